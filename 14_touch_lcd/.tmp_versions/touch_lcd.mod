@@ -1,3 +0,0 @@
-/home/lvd/workspace/drivers/14_touch_lcd/touch_lcd.ko
-/home/lvd/workspace/drivers/14_touch_lcd/touch_lcd.o
-
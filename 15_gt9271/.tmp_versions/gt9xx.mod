@@ -1,3 +0,0 @@
-/home/lvd/workspace/drivers/15_gt9271/gt9xx.ko
-/home/lvd/workspace/drivers/15_gt9271/gt9xx.o
-
@@ -0,0 +1,61 @@
+/*
+ * GOODiX GT9xx寄存器访问(regmap-i2c)
+ *
+ * 寄存器地址16位,数据8位.
+ * 配置区0x8047~0x8100和ID区0x8140~0x814D只在写配置时改变,使用缓存,
+ * probe回读一次之后再读这些寄存器不访问总线;
+ * 命令寄存器和坐标寄存器是易失的,不缓存.
+ * 寄存器读写可以在regmap的debugfs和tracepoint中看到.
+ */
+#ifndef __GOODIX_REGMAP_H
+#define __GOODIX_REGMAP_H
+
+#include <linux/regmap.h>
+
+#define GOODIX_REGMAP_CFG_FIRST		0x8047
+#define GOODIX_REGMAP_CFG_LAST		0x8100		//配置更新标志
+#define GOODIX_REGMAP_ID_FIRST		0x8140
+#define GOODIX_REGMAP_ID_LAST		0x814D		//ID、固件版本、分辨率等
+#define GOODIX_REGMAP_MAX			0x81FF
+
+static bool goodix_regmap_volatile(struct device *dev, unsigned int reg)
+{
+	if (reg >= GOODIX_REGMAP_CFG_FIRST && reg <= GOODIX_REGMAP_CFG_LAST)
+		return false;
+	if (reg >= GOODIX_REGMAP_ID_FIRST && reg <= GOODIX_REGMAP_ID_LAST)
+		return false;
+	return true;
+}
+
+static const struct regmap_config goodix_regmap_config = {
+	.reg_bits		= 16,
+	.val_bits		= 8,
+	.max_register	= GOODIX_REGMAP_MAX,
+	.volatile_reg	= goodix_regmap_volatile,
+	.cache_type		= REGCACHE_RBTREE,
+};
+
+/*
+ * 用一次i2c传输读出一段可缓存的寄存器,并填入缓存.
+ * 对非volatile区regmap_bulk_read不看cache_bypass,缓存未命中时逐个寄存器
+ * 访问总线;regmap_raw_read在cache_bypass时整段读取.寄存器为8位,原始格式
+ * 与buf相同
+ */
+static inline int goodix_regmap_fill_cache(struct regmap *map,
+			unsigned int reg, void *buf, size_t len)
+{
+	int ret;
+
+	regcache_cache_bypass(map, true);
+	ret = regmap_raw_read(map, reg, buf, len);
+	regcache_cache_bypass(map, false);
+	if (ret)
+		return ret;
+
+	regcache_cache_only(map, true);
+	ret = regmap_bulk_write(map, reg, buf, len);
+	regcache_cache_only(map, false);
+	return ret;
+}
+
+#endif
@@ -3,33 +3,104 @@
  文件名    : gt9xx.c
  作者      : 邓涛
  版本      : V1.0
- 描述      : GOODiX GT9147/GT9271触摸屏驱动程序
+ 描述      : GOODiX GT9147/GT9271/GT911触摸屏驱动程序
  其他      : 无
  论坛      : www.openedv.com
  日志      : 初版V1.0 2020/7/26 邓涛创建
+             V1.1 合并14_touch_lcd的GT9271驱动,状态全部放在设备结构体中,
+                  支持多个触摸屏同时使用
  ***************************************************************/
 
 #include <linux/module.h>
 #include <linux/i2c.h>
 #include <linux/input/mt.h>
+#include <linux/input/touchscreen.h>
 #include <linux/of_gpio.h>
 #include <linux/delay.h>
 #include <linux/interrupt.h>
 #include <linux/of_device.h>
+#include <linux/ktime.h>
+#include <linux/version.h>
+#include <linux/hrtimer.h>
+#include <linux/workqueue.h>
+#include <linux/mutex.h>
+#include <linux/sysfs.h>
+#include <linux/firmware.h>
+#include <linux/irq.h>
+#include <linux/bitops.h>
+#include <linux/fb.h>
+#include <linux/notifier.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include "goodix_regmap.h"
+
+#define CREATE_TRACE_POINTS
+#include "gt9xx_trace.h"
 
 /* 寄存器定义 */
 #define GOODIX_REG_COMMAND		0x8040
+#define GOODIX_CMD_SLEEP		0x05		//写入0x8040进入睡眠
 #define GOODIX_REG_CFG_DATA		0x8047
 #define GOODIX_REG_CFG_CSM		0x80FF
 #define GOODIX_REG_ID			0x8140
 #define GOODIX_READ_COOR_ADDR	0x814E
+#define GOODIX_REG_FILTER		0x8050		//低6位: 坐标滤波强度
+#define GOODIX_REG_TOUCH_LEVEL	0x8053		//按下阈值
+#define GOODIX_REG_LEAVE_LEVEL	0x8054		//松开阈值
+#define GOODIX_REG_REFRESH_RATE	0x8056		//坐标上报周期,低4位+5ms
+
+#define GOODIX_CFG_CSM_LEN		(GOODIX_REG_CFG_CSM - GOODIX_REG_CFG_DATA)	//参与校验的配置长度
+#define GOODIX_CFG_OFFSET(reg)	((reg) - GOODIX_REG_CFG_DATA)
+
+#define GOODIX_POINT_SIZE		8		//每个触摸点8字节
+#define GOODIX_MAX_POINTS		10
+#define GOODIX_RBUF_LEN			(GOODIX_CFG_CSM_LEN + 1)	//坐标数据(1+8*10字节)和配置回读共用
+/*
+ * 坐标滤波,定点数,低4位为小数(1/16像素)
+ * deadzone: 按下后移动超过此距离(像素)才开始跟随,长按时的抖动不产生事件
+ * hysteresis: 跟随时输出落后输入的距离(1/16像素),小范围来回抖动不产生事件
+ */
+#define GOODIX_FILTER_SHIFT		4
+#define GOODIX_DEF_DEADZONE		2
+#define GOODIX_DEF_HYSTERESIS	8
+
+/*
+ * 运动预测: 按每个触摸点的速度把位置外推predict_ms毫秒,抵消输入、渲染、
+ * 扫描输出的延迟.主input设备始终上报实际位置;设备树goodix,predict-ms非0时
+ * 另外注册一个"... (predicted)"input设备上报预测位置,需要的应用自行选用.
+ * 速度由硬中断时间戳计算,单位1/16像素每毫秒,做1/2的指数平滑.
+ * 减速时按减速程度连续缩短外推时长,松开时预测设备先回到实际位置再抬起,
+ * 避免停下或抬起时冲过头.
+ */
+#define GOODIX_PREDICT_MAX_MS	50
+/*
+ * 速度平方与上一帧之比不低于7/8时(匀速拖动时平滑后速度的正常抖动)按完整时长
+ * 外推,低于时按比例连续缩短,比值在阈值两侧变化时预测位置不会跳变
+ */
+#define GOODIX_PREDICT_DECEL_NUM	7
+#define GOODIX_PREDICT_DECEL_DEN	8
+#define GOODIX_PREDICT_GAP_US	100000	//两帧间隔超过100ms不计算速度
+
+#define GOODIX_POLL_IDLE_MAX	5		//轮询时连续多少个周期没有新坐标就恢复中断
+
+#define GOODIX_HIST_BINS		20		//第i格为[2^i, 2^(i+1))us,第0格包含0
+
+/* 延时直方图,debugfs中查看 */
+struct goodix_hist {
+	u32 count[GOODIX_HIST_BINS];
+	u32 n;
+	u64 sum_ns;
+	u64 max_ns;
+};
 
 /*
  *GT9271配置参数表
  *第一个字节为版本号,必须保证新的版本号大于等于GT9147内部
  *flash原有版本号,才会更新配置.
  */
-static u8 gt9271_cfg_data[]=
+static const u8 gt9271_cfg_data[]=
 {
 	0x41,0x00,0x05,0x20,0x03,0x0A,0x3d,0x20,0x01,0x0A,
 	0x28,0x0F,0x6E,0x5A,0x03,0x05,0x00,0x00,0x00,0x00,
@@ -57,7 +128,7 @@ static u8 gt9271_cfg_data[]=
  *第一个字节为版本号,必须保证新的版本号大于等于GT9147内部
  *flash原有版本号,才会更新配置.
  */
-static u8 gt9147_cfg_data[]=
+static const u8 gt9147_cfg_data[]=
 {
 	0x41,0x20,0x03,0xE0,0x01,0x05,0x0d,0x00,0x01,0x08,
 	0x28,0x05,0x50,0x32,0x03,0x05,0x00,0x00,0xff,0xff,
@@ -80,110 +151,148 @@ static u8 gt9147_cfg_data[]=
 	0xff,0xff,0xff,0xff,
 };
 
-/* 自定义结构体,用于描述goodix触摸屏设备 */
+/*
+ * 自定义结构体,用于描述goodix触摸屏设备
+ * 每个触摸屏一个实例,所有跟踪状态都在这里,多个触摸屏互不影响
+ */
 struct goodix_gt9xx_dev {
 	struct i2c_client *client;
 	struct input_dev *input;
+	struct input_dev *pred_input;	//预测位置,没有启用预测时为NULL
+	struct touchscreen_properties prop;	//设备树中的分辨率、翻转、XY交换
 	int max_support_points;		//支持的最大触摸点数
+	unsigned long active_slots;	//上一帧按下的触摸点id位图
+
+	/* 每个触摸点滤波后的坐标 */
+	struct goodix_contact {
+		int x, y;				//定点数
+		bool moving;			//已移出死区
+		int vx, vy;				//速度,1/16像素每毫秒
+		int px, py;				//上一帧位置,定点数
+		ktime_t t;				//上一帧时间
+		int rx, ry;				//预测设备上一帧上报的位置
+	} contacts[GOODIX_MAX_POINTS];
+	u32 predict_ms;				//预测时长,0表示不预测
+	u32 deadzone;				//像素
+	u32 hysteresis;				//1/16像素
 	int reset_gpio;
 	int irq_gpio;
+	struct regmap *regmap;
+	/* 读缓冲区,单独kmalloc分配,可用于DMA */
+	u8 *rbuf;					//状态字节+坐标数据,或配置回读
+	int last_touch;				//上一帧触摸点数,决定下一次读取长度
+	ktime_t irq_time;			//硬中断到来的时间,作为本帧事件的时间戳
+
+	/*
+	 * 轮询模式
+	 * poll_on_touch: 手指按下后关闭中断,按芯片上报周期用hrtimer轮询,全部松开后恢复中断
+	 * 没有中断线(client->irq <= 0)时一直轮询
+	 * hrtimer回调中不能做i2c传输,由poll_work完成读取和上报
+	 */
+	bool poll_on_touch;
+	bool polling;
+	int poll_idle;				//连续没有新坐标的轮询次数
+	ktime_t poll_period;
+	struct hrtimer poll_timer;
+	struct work_struct poll_work;
+	struct mutex lock;			//中断线程、轮询work和sysfs互斥
+
+	u8 *cfg;					//当前配置(0x8047~0x80FE),可通过sysfs修改
+
+	/* 复位和配置耗时约100ms,放在init_work中完成,不阻塞启动 */
+	const struct goodix_i2c_chip_data *chip_data;
+	struct work_struct init_work;
+	bool ready;					//芯片已完成复位和配置
+	bool keep_cfg;				//既没有内置配置也没有配置文件,沿用芯片中的配置
+
+	/*
+	 * 显示屏关闭时让芯片睡眠,停止扫描和中断
+	 * fb_index: 跟随的fb设备号,-1表示任意fb
+	 */
+	struct notifier_block fb_notif;
+	struct work_struct blank_work;
+	int fb_index;
+	bool blanked;				//显示屏已关闭
+	bool sleeping;				//芯片处于睡眠状态
+
+	/*
+	 * 延时统计
+	 * lat_hist: 硬中断(或轮询定时器)到input_sync
+	 * bus_hist: 每次上报的i2c传输总时间
+	 */
+	s64 bus_ns;					//本次上报累计的i2c时间
+	struct goodix_hist lat_hist;
+	struct goodix_hist bus_hist;
+	struct dentry *debugfs;
 };
 
+/*
+ *配置文件名,放在/lib/firmware下,每种屏可以有自己的配置,
+ *内容为0x8047开始的配置数据,至少184字节,多出的部分(校验和等)忽略.
+ *找不到文件时使用驱动内置的配置表
+ */
+#define GOODIX_GT9147_CFG_NAME	"goodix_gt9147_cfg.bin"
+#define GOODIX_GT9271_CFG_NAME	"goodix_gt9271_cfg.bin"
+#define GOODIX_GT911_CFG_NAME	"goodix_gt911_cfg.bin"
+
 /* goodix触摸IC信息 */
 struct goodix_i2c_chip_data {
 	int max_support_points;		//支持的最大触摸点数
 	int abs_x_max;				//X轴最大值
 	int abs_y_max;				//Y轴最大值
-	int (*chip_cfg)(struct goodix_gt9xx_dev *);	//配置函数
+	const u8 *cfg;				//内置配置表,NULL表示没有
+	const char *cfg_name;		//配置文件名
 };
 
+/* 寄存器读写,经由regmap,配置区和ID区读缓存,其余直接访问总线 */
 static int goodix_gt9xx_ts_write(struct goodix_gt9xx_dev *gt9xx,
-			u16 addr, u8 *buf, u16 len)
+			u16 addr, const u8 *buf, u16 len)
 {
-	struct i2c_client *client = gt9xx->client;
-	struct i2c_msg msg;
-	u8 send_buf[190] = {0};		//gt9147/gt9271最大配置长度+4
 	int ret;
 
-	send_buf[0] = addr >> 8;
-	send_buf[1] = addr & 0xFF;
-	memcpy(&send_buf[2], buf, len);
-
-	msg.flags = 0;			//i2c写
-	msg.addr = client->addr;
-	msg.buf = send_buf;
-	msg.len = len + 2;
-
-	ret = i2c_transfer(client->adapter, &msg, 1);
-	if (1 == ret)
-		return 0;
-	else {
-		dev_err(&client->dev, "%s: write error, addr=0x%x len=%d.\n",
+	ret = regmap_bulk_write(gt9xx->regmap, addr, buf, len);
+	if (ret)
+		dev_err(&gt9xx->client->dev, "%s: write error, addr=0x%x len=%d.\n",
 					__func__, addr, len);
-		return -1;
-	}
+	return ret;
 }
 
 static int goodix_gt9xx_ts_read(struct goodix_gt9xx_dev *gt9xx,
 			u16 addr, u8 *buf, u16 len)
 {
-	struct i2c_client *client = gt9xx->client;
-	struct i2c_msg msg[2];
-	u8 send_buf[2];
 	int ret;
 
-	send_buf[0] = addr >> 8;
-	send_buf[1] = addr & 0xFF;
-
-	msg[0].flags = 0;			// i2c写
-	msg[0].addr = client->addr;
-	msg[0].buf = send_buf;
-	msg[0].len = 2;				// 2个字节
-
-	msg[1].flags = I2C_M_RD;	//i2c读
-	msg[1].addr = client->addr;
-	msg[1].buf = buf;
-	msg[1].len = len;
-
-	ret = i2c_transfer(client->adapter, msg, 2);
-	if (2 == ret)
-		return 0;
-	else {
-		dev_err(&client->dev, "%s: read error, addr=0x%x len=%d.\n",
+	ret = regmap_bulk_read(gt9xx->regmap, addr, buf, len);
+	if (ret)
+		dev_err(&gt9xx->client->dev, "%s: read error, addr=0x%x len=%d.\n",
 					__func__, addr, len);
-		return -1;
-	}
+	return ret;
 }
 
-static int goodix_gt9147_cfg(struct goodix_gt9xx_dev *gt9xx)
+/*
+ * 写入配置
+ * 校验和为0x8047~0x80FE所有字节之和取补,和配置更新标志一起写入0x80FF/0x8100.
+ * 调用前芯片须处于软件复位状态,写完后结束复位回到读坐标模式
+ */
+static u8 goodix_gt9xx_ts_cfg_csum(const u8 *cfg)
 {
-	struct i2c_client *client = gt9xx->client;
-	u8 buf[5] = {0};
+	u8 csum = 0;
 	int i;
 
-	/* 读取Chip ID */
-	goodix_gt9xx_ts_read(gt9xx, GOODIX_REG_ID, buf, 4);
-	dev_info(&client->dev, "Chip ID: %s\n",  buf);
-
-	/* 软件复位 */
-	buf[0] = 0x2;
-	goodix_gt9xx_ts_write(gt9xx, GOODIX_REG_COMMAND, buf, 1);
-
-	/* 读取配置文件版本号 */
-	goodix_gt9xx_ts_read(gt9xx, GOODIX_REG_CFG_DATA, buf, 1);
-	gt9147_cfg_data[0] = buf[0];	//写入版本号等于IC原有版本号
+	for (i = 0; i < GOODIX_CFG_CSM_LEN; i++)
+		csum += cfg[i];
+	return (~csum) + 1;
+}
 
-	/* 计算校验和 */
-	buf[0] = 0;
-	buf[1] = 1;
-	for(i = 0; i < sizeof(gt9147_cfg_data); i++)
-		buf[0] += gt9147_cfg_data[i];
-	buf[0] = (~buf[0]) + 1;
+static int goodix_gt9xx_ts_write_cfg(struct goodix_gt9xx_dev *gt9xx)
+{
+	u8 buf[2] = {goodix_gt9xx_ts_cfg_csum(gt9xx->cfg), 1};
+	int ret;
 
-	/* 配置寄存器 */
-	goodix_gt9xx_ts_write(gt9xx, GOODIX_REG_CFG_DATA,
-				gt9147_cfg_data, sizeof(gt9147_cfg_data));
-	goodix_gt9xx_ts_write(gt9xx, GOODIX_REG_CFG_CSM, buf, 2);	// 写入校验和,更新配置
+	ret = goodix_gt9xx_ts_write(gt9xx, GOODIX_REG_CFG_DATA,
+				gt9xx->cfg, GOODIX_CFG_CSM_LEN);
+	if (!ret)
+		ret = goodix_gt9xx_ts_write(gt9xx, GOODIX_REG_CFG_CSM, buf, 2);	// 写入校验和,更新配置
 
 	/* 结束软件复位,回到读坐标模式 */
 	msleep(1);
@@ -191,49 +300,279 @@ static int goodix_gt9147_cfg(struct goodix_gt9xx_dev *gt9xx)
 	goodix_gt9xx_ts_write(gt9xx, GOODIX_REG_COMMAND, buf, 1);
 	goodix_gt9xx_ts_write(gt9xx, GOODIX_READ_COOR_ADDR, buf, 1);
 
+	return ret;
+}
+
+/*
+ * 加载配置: 优先使用配置文件,没有则使用内置配置表
+ * 配置存放在per-device的副本中,sysfs修改的也是这份副本
+ */
+static int goodix_gt9xx_ts_load_cfg(struct goodix_gt9xx_dev *gt9xx,
+			const struct goodix_i2c_chip_data *chip_data)
+{
+	struct device *dev = &gt9xx->client->dev;
+	const struct firmware *fw;
+	const char *name = chip_data->cfg_name;
+
+	of_property_read_string(dev->of_node, "goodix,config-name", &name);
+	/* 配置文件是可选的,找不到时不打印警告 */
+	if (!firmware_request_nowarn(&fw, name, dev)) {
+		if (fw->size >= GOODIX_CFG_CSM_LEN) {
+			memcpy(gt9xx->cfg, fw->data, GOODIX_CFG_CSM_LEN);
+			release_firmware(fw);
+			dev_info(dev, "using config %s\n", name);
+			return 0;
+		}
+		dev_warn(dev, "%s too short (%zu bytes), using built-in config\n",
+					name, fw->size);
+		release_firmware(fw);
+	}
+
+	if (chip_data->cfg)
+		memcpy(gt9xx->cfg, chip_data->cfg, GOODIX_CFG_CSM_LEN);
+	else
+		gt9xx->keep_cfg = true;
 	return 0;
 }
 
-static int goodix_gt9271_cfg(struct goodix_gt9xx_dev *gt9xx)
+/*
+ * 初始化配置
+ * 先回读芯片当前配置(0x8047~0x80FF),与要写的配置和校验和一致时跳过
+ * 软件复位和写配置,避免每次开机都重写flash
+ */
+static int goodix_gt9xx_ts_cfg(struct goodix_gt9xx_dev *gt9xx)
 {
 	struct i2c_client *client = gt9xx->client;
-	u8 buf[5] = {0};
-	int i;
+	u8 *buf = gt9xx->rbuf;
+	int ret;
 
-	/* 读取Chip ID */
-	goodix_gt9xx_ts_read(gt9xx, GOODIX_REG_ID, buf, 4);
+	/* 读取Chip ID,ID区填入缓存 */
+	ret = goodix_regmap_fill_cache(gt9xx->regmap, GOODIX_REG_ID, buf,
+				GOODIX_REGMAP_ID_LAST - GOODIX_REG_ID + 1);
+	if (ret)
+		return ret;
+	buf[4] = '\0';
 	dev_info(&client->dev, "Chip ID: %s\n",  buf);
 
+	/* 回读当前配置和校验和,同时填入缓存 */
+	ret = goodix_regmap_fill_cache(gt9xx->regmap, GOODIX_REG_CFG_DATA, buf,
+				GOODIX_CFG_CSM_LEN + 1);
+	if (ret)
+		return ret;
+	if (gt9xx->keep_cfg) {
+		memcpy(gt9xx->cfg, buf, GOODIX_CFG_CSM_LEN);
+		return 0;
+	}
+	gt9xx->cfg[0] = buf[0];	//写入版本号等于IC原有版本号
+
+	if (!memcmp(buf, gt9xx->cfg, GOODIX_CFG_CSM_LEN) &&
+		buf[GOODIX_CFG_CSM_LEN] == goodix_gt9xx_ts_cfg_csum(gt9xx->cfg)) {
+		dev_info(&client->dev, "config version 0x%02x up to date\n", buf[0]);
+		return 0;
+	}
+
 	/* 软件复位 */
 	buf[0] = 0x2;
 	goodix_gt9xx_ts_write(gt9xx, GOODIX_REG_COMMAND, buf, 1);
 
-	/* 读取配置文件版本号 */
-	goodix_gt9xx_ts_read(gt9xx, GOODIX_REG_CFG_DATA, buf, 1);
-	gt9271_cfg_data[0] = buf[0];	//写入版本号等于IC原有版本号
+	return goodix_gt9xx_ts_write_cfg(gt9xx);
+}
 
-	/* 计算校验和 */
-	buf[0] = 0;
-	buf[1] = 1;
-	for(i = 0; i < sizeof(gt9271_cfg_data) - 2; i++)
-		buf[0] += gt9271_cfg_data[i];
-	buf[0] = (~buf[0]) + 1;
+/* 修改配置中的一个字节(mask内的位),软件复位后重新写入,不需要重新probe */
+static int goodix_gt9xx_ts_update_cfg(struct goodix_gt9xx_dev *gt9xx,
+			u16 reg, u8 mask, u8 val)
+{
+	u8 *p = &gt9xx->cfg[GOODIX_CFG_OFFSET(reg)];
+	u8 cmd = 0x2;
+	int ret;
 
-	/* 配置寄存器 */
-	goodix_gt9xx_ts_write(gt9xx, GOODIX_REG_CFG_DATA,
-				gt9271_cfg_data, sizeof(gt9271_cfg_data));
-	goodix_gt9xx_ts_write(gt9xx, GOODIX_REG_CFG_CSM, buf, 2);	// 写入校验和,更新配置
+	mutex_lock(&gt9xx->lock);
+	if (!gt9xx->ready || gt9xx->sleeping) {
+		mutex_unlock(&gt9xx->lock);
+		return -EBUSY;
+	}
+	*p = (*p & ~mask) | (val & mask);
 
-	/* 结束软件复位,回到读坐标模式 */
-	msleep(1);
-	buf[0] = 0x0;
-	goodix_gt9xx_ts_write(gt9xx, GOODIX_REG_COMMAND, buf, 1);
-	goodix_gt9xx_ts_write(gt9xx, GOODIX_READ_COOR_ADDR, buf, 1);
+	ret = goodix_gt9xx_ts_write(gt9xx, GOODIX_REG_COMMAND, &cmd, 1);
+	if (!ret)
+		ret = goodix_gt9xx_ts_write_cfg(gt9xx);
 
-	return 0;
+	/* 轮询周期跟随上报周期 */
+	if (reg == GOODIX_REG_REFRESH_RATE)
+		gt9xx->poll_period = ms_to_ktime((*p & 0x0F) + 5);
+	mutex_unlock(&gt9xx->lock);
+
+	return ret;
+}
+
+/*
+ * sysfs属性
+ * report_rate: 坐标上报频率(Hz),芯片按5~20ms的周期上报,即50~200Hz
+ * touch_threshold/leave_threshold: 按下/松开阈值
+ * filter: 坐标滤波强度0~63,越大越平滑但延迟越大
+ */
+static ssize_t report_rate_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	struct goodix_gt9xx_dev *gt9xx = dev_get_drvdata(dev);
+	u8 rate = gt9xx->cfg[GOODIX_CFG_OFFSET(GOODIX_REG_REFRESH_RATE)];
+
+	return sprintf(buf, "%d\n", 1000 / ((rate & 0x0F) + 5));
 }
 
-static int goodix_gt9xx_ts_reset(struct goodix_gt9xx_dev *gt9xx)
+static ssize_t report_rate_store(struct device *dev,
+			struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct goodix_gt9xx_dev *gt9xx = dev_get_drvdata(dev);
+	unsigned int hz, period;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &hz);
+	if (ret)
+		return ret;
+	if (!hz)
+		return -EINVAL;
+
+	period = clamp(DIV_ROUND_CLOSEST(1000U, hz), 5U, 20U);
+	ret = goodix_gt9xx_ts_update_cfg(gt9xx, GOODIX_REG_REFRESH_RATE,
+				0x0F, period - 5);
+	return ret ? ret : count;
+}
+static DEVICE_ATTR_RW(report_rate);
+
+/* deadzone(像素)、hysteresis(1/16像素)是驱动内的滤波参数,不写入芯片 */
+static ssize_t deadzone_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	struct goodix_gt9xx_dev *gt9xx = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%u\n", READ_ONCE(gt9xx->deadzone));
+}
+
+static ssize_t deadzone_store(struct device *dev,
+			struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct goodix_gt9xx_dev *gt9xx = dev_get_drvdata(dev);
+	u8 val;
+	int ret;
+
+	ret = kstrtou8(buf, 0, &val);
+	if (ret)
+		return ret;
+	WRITE_ONCE(gt9xx->deadzone, val);
+	return count;
+}
+static DEVICE_ATTR_RW(deadzone);
+
+static ssize_t hysteresis_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	struct goodix_gt9xx_dev *gt9xx = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%u\n", READ_ONCE(gt9xx->hysteresis));
+}
+
+static ssize_t hysteresis_store(struct device *dev,
+			struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct goodix_gt9xx_dev *gt9xx = dev_get_drvdata(dev);
+	u8 val;
+	int ret;
+
+	ret = kstrtou8(buf, 0, &val);
+	if (ret)
+		return ret;
+	WRITE_ONCE(gt9xx->hysteresis, val);
+	return count;
+}
+static DEVICE_ATTR_RW(hysteresis);
+
+/* predict_ms: 运动预测时长(毫秒),0关闭.只有probe时已启用预测才可修改 */
+static ssize_t predict_ms_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	struct goodix_gt9xx_dev *gt9xx = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%u\n", READ_ONCE(gt9xx->predict_ms));
+}
+
+static ssize_t predict_ms_store(struct device *dev,
+			struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct goodix_gt9xx_dev *gt9xx = dev_get_drvdata(dev);
+	u32 val;
+	int ret;
+
+	ret = kstrtou32(buf, 0, &val);
+	if (ret)
+		return ret;
+	if (val > GOODIX_PREDICT_MAX_MS)
+		return -EINVAL;
+	if (!gt9xx->pred_input)
+		return -ENODEV;
+	WRITE_ONCE(gt9xx->predict_ms, val);
+	return count;
+}
+static DEVICE_ATTR_RW(predict_ms);
+
+static ssize_t goodix_gt9xx_cfg_show(struct device *dev, char *buf,
+			u16 reg, u8 mask)
+{
+	struct goodix_gt9xx_dev *gt9xx = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%d\n", gt9xx->cfg[GOODIX_CFG_OFFSET(reg)] & mask);
+}
+
+static ssize_t goodix_gt9xx_cfg_store(struct device *dev, const char *buf,
+			size_t count, u16 reg, u8 mask)
+{
+	struct goodix_gt9xx_dev *gt9xx = dev_get_drvdata(dev);
+	u8 val;
+	int ret;
+
+	ret = kstrtou8(buf, 0, &val);
+	if (ret)
+		return ret;
+	if (val & ~mask)
+		return -EINVAL;
+
+	ret = goodix_gt9xx_ts_update_cfg(gt9xx, reg, mask, val);
+	return ret ? ret : count;
+}
+
+#define GOODIX_CFG_ATTR(_name, _reg, _mask)								\
+static ssize_t _name##_show(struct device *dev,							\
+			struct device_attribute *attr, char *buf)					\
+{																		\
+	return goodix_gt9xx_cfg_show(dev, buf, _reg, _mask);				\
+}																		\
+static ssize_t _name##_store(struct device *dev,						\
+			struct device_attribute *attr, const char *buf, size_t count)	\
+{																		\
+	return goodix_gt9xx_cfg_store(dev, buf, count, _reg, _mask);		\
+}																		\
+static DEVICE_ATTR_RW(_name)
+
+GOODIX_CFG_ATTR(touch_threshold, GOODIX_REG_TOUCH_LEVEL, 0xFF);
+GOODIX_CFG_ATTR(leave_threshold, GOODIX_REG_LEAVE_LEVEL, 0xFF);
+GOODIX_CFG_ATTR(filter, GOODIX_REG_FILTER, 0x3F);
+
+static struct attribute *goodix_gt9xx_attrs[] = {
+	&dev_attr_report_rate.attr,
+	&dev_attr_touch_threshold.attr,
+	&dev_attr_leave_threshold.attr,
+	&dev_attr_filter.attr,
+	&dev_attr_deadzone.attr,
+	&dev_attr_hysteresis.attr,
+	&dev_attr_predict_ms.attr,
+	NULL
+};
+
+static const struct attribute_group goodix_gt9xx_attr_group = {
+	.attrs = goodix_gt9xx_attrs,
+};
+
+static int goodix_gt9xx_ts_get_gpio(struct goodix_gt9xx_dev *gt9xx)
 {
 	struct i2c_client *client = gt9xx->client;
 	int ret;
@@ -262,6 +601,24 @@ static int goodix_gt9xx_ts_reset(struct goodix_gt9xx_dev *gt9xx)
 	if (ret < 0)
 		return ret;
 
+	return 0;
+}
+
+/* 复位和唤醒的最后一步: INT拉低50ms后转为输入 */
+static void goodix_gt9xx_ts_int_sync(struct goodix_gt9xx_dev *gt9xx)
+{
+	/* 中断管脚拉低 */
+	gpio_direction_output(gt9xx->irq_gpio, 0);
+	msleep(50);					/* T5: 50ms */
+
+	/* 将中断引脚设置为输入模式 */
+	gpio_direction_input(gt9xx->irq_gpio);
+}
+
+static void goodix_gt9xx_ts_reset(struct goodix_gt9xx_dev *gt9xx)
+{
+	struct i2c_client *client = gt9xx->client;
+
 	/*
 	 *硬件复位开始
 	 *这里严格按照官方参考手册提供的复位时序
@@ -281,25 +638,55 @@ static int goodix_gt9xx_ts_reset(struct goodix_gt9xx_dev *gt9xx)
 	/* end select I2C slave addr */
 	gpio_direction_input(gt9xx->reset_gpio);
 
-	/* 中断管脚拉低 */
-	gpio_set_value_cansleep(gt9xx->irq_gpio, 0);
-	msleep(50);					/* T5: 50ms */
+	goodix_gt9xx_ts_int_sync(gt9xx);
+}
 
-	/* 将中断引脚设置为输入模式 */
-	gpio_direction_input(gt9xx->irq_gpio);
-	return 0;
+/* 从t到现在的纳秒数 */
+static s64 goodix_gt9xx_since(ktime_t t)
+{
+	return ktime_to_ns(ktime_sub(ktime_get(), t));
 }
 
-static int goodix_gt9xx_ts_get_points(struct goodix_gt9xx_dev *gt9xx, u8 *buf)
+static void goodix_gt9xx_hist_add(struct goodix_hist *h, s64 ns)
 {
-	u8 state = 0;
+	u64 us = div_u64(max_t(s64, ns, 0), NSEC_PER_USEC);
+	int bin = us ? min_t(int, ilog2(us), GOODIX_HIST_BINS - 1) : 0;
+
+	h->count[bin]++;
+	h->n++;
+	h->sum_ns += ns;
+	h->max_ns = max_t(u64, h->max_ns, ns);
+}
+
+/*
+ * 读取触摸点
+ * 状态寄存器0x814E之后紧跟坐标数据,按上一帧的触摸点数预测本次点数,
+ * 在一次i2c传输中读出状态和坐标;实际点数更多时再补读剩余部分.
+ * 连续滑动时每次上报只需要一次读和一次清状态的写.
+ * 成功时*points指向第一个触摸点的数据
+ */
+static int goodix_gt9xx_ts_get_points(struct goodix_gt9xx_dev *gt9xx, u8 **points)
+{
+	u8 *buf = gt9xx->rbuf;
+	int expect = clamp(gt9xx->last_touch, 1, gt9xx->max_support_points);
 	int touch_num = 0;
+	struct device *dev = &gt9xx->client->dev;
+	ktime_t t;
+	s64 ns;
+	u8 state;
 	int ret;
 
-	ret = goodix_gt9xx_ts_read(gt9xx, GOODIX_READ_COOR_ADDR, &state, 1);
+	t = ktime_get();
+	ret = goodix_gt9xx_ts_read(gt9xx, GOODIX_READ_COOR_ADDR, buf,
+				1 + GOODIX_POINT_SIZE * expect);
+	ns = goodix_gt9xx_since(t);
+	gt9xx->bus_ns += ns;
+	trace_goodix_status_read(dev, ret ? 0 : buf[0],
+				1 + GOODIX_POINT_SIZE * expect, ns, ret);
 	if (ret)
 		return ret;
 
+	state = buf[0];
 	if ((state & 0x80) == 0)		// 判断数据是否准备好
 		return -1;
 
@@ -309,95 +696,380 @@ static int goodix_gt9xx_ts_get_points(struct goodix_gt9xx_dev *gt9xx, u8 *buf)
 		goto out;
 	}
 
-	if (touch_num) {
-		/* 读取触摸点坐标数据，从0x814F寄存器开始读取
-		 * 其中每一个触摸点使用8个寄存器来描述
-		 * 以第一个触摸点为例，各寄存器描述信息如下：
-		 * 0x814F: 触摸点id
-		 * 0x8150: 触摸点X轴坐标低位字节
-		 * 0x8151: 触摸点X轴坐标高位字节
-		 * 0x8152: 触摸点Y轴坐标低位字节
-		 * 0x8153: 触摸点Y轴坐标高位字节
-		 * 0x8154~0x8155: 触摸点的大小信息，我们不需要
-		 * 0x8156: 保留
-		 */
-		ret = goodix_gt9xx_ts_read(gt9xx, GOODIX_READ_COOR_ADDR + 1,
-					buf, 8 * touch_num);
+	/* 读取触摸点坐标数据，从0x814F寄存器开始
+	 * 其中每一个触摸点使用8个寄存器来描述
+	 * 以第一个触摸点为例，各寄存器描述信息如下：
+	 * 0x814F: 触摸点id
+	 * 0x8150: 触摸点X轴坐标低位字节
+	 * 0x8151: 触摸点X轴坐标高位字节
+	 * 0x8152: 触摸点Y轴坐标低位字节
+	 * 0x8153: 触摸点Y轴坐标高位字节
+	 * 0x8154~0x8155: 触摸点的大小信息，我们不需要
+	 * 0x8156: 保留
+	 */
+	if (touch_num > expect) {
+		/* 预测少了,补读剩下的点 */
+		t = ktime_get();
+		ret = goodix_gt9xx_ts_read(gt9xx,
+					GOODIX_READ_COOR_ADDR + 1 + GOODIX_POINT_SIZE * expect,
+					buf + 1 + GOODIX_POINT_SIZE * expect,
+					GOODIX_POINT_SIZE * (touch_num - expect));
+		ns = goodix_gt9xx_since(t);
+		gt9xx->bus_ns += ns;
+		trace_goodix_points_read(dev, state,
+					GOODIX_POINT_SIZE * (touch_num - expect), ns, ret);
 		if (ret)
 			touch_num = -1;
 	}
+	if (touch_num >= 0)
+		gt9xx->last_touch = touch_num;
+	*points = buf + 1;
 
 out:
 	state = 0x0;
-	goodix_gt9xx_ts_write(gt9xx, GOODIX_READ_COOR_ADDR, &state, 1);	//清buffer
+	t = ktime_get();
+	ret = goodix_gt9xx_ts_write(gt9xx, GOODIX_READ_COOR_ADDR, &state, 1);	//清buffer
+	ns = goodix_gt9xx_since(t);
+	gt9xx->bus_ns += ns;
+	trace_goodix_clear_write(dev, state, 1, ns, ret);
 	return touch_num;
 }
 
-static irqreturn_t goodix_gt9xx_ts_isr(int irq, void *dev_id)
+/*
+ * 中断上半部: 只记录时间戳
+ * 线程被调度和i2c读取的耗时不固定,在这里取时间才能反映真实的触摸时刻
+ */
+static irqreturn_t goodix_gt9xx_ts_hardirq(int irq, void *dev_id)
 {
 	struct goodix_gt9xx_dev *gt9xx = dev_id;
-	static int pre_touch = 0;		//上一次触摸点数
-	static int pre_ids[10] = {0};	//上一次触摸点的id
+
+	gt9xx->irq_time = ktime_get();
+	trace_goodix_hardirq(&gt9xx->client->dev, irq);
+	return IRQ_WAKE_THREAD;
+}
+
+/* 把硬中断时间戳附加到本帧事件上,5.6之前的内核没有input_set_timestamp,用MSC_TIMESTAMP上报 */
+static void goodix_gt9xx_ts_timestamp(struct goodix_gt9xx_dev *gt9xx,
+			struct input_dev *input)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+	input_set_timestamp(input, gt9xx->irq_time);
+#else
+	input_event(input, EV_MSC, MSC_TIMESTAMP,
+				(u32)ktime_to_us(gt9xx->irq_time));
+#endif
+}
+
+/* 滞回: 输入离输出超过h时输出跟过去,保持相差h */
+static int goodix_gt9xx_hysteresis(int out, int in, int h)
+{
+	if (in > out + h)
+		return in - h;
+	if (in < out - h)
+		return in + h;
+	return out;
+}
+
+/*
+ * 坐标滤波,结果写回*x,*y,返回上报位置是否变化(新按下的点算变化)
+ * 坐标不变时input核心不会再产生ABS事件,长按和慢速拖动时事件大大减少
+ */
+static bool goodix_gt9xx_ts_filter(struct goodix_gt9xx_dev *gt9xx,
+			int id, int *x, int *y)
+{
+	struct goodix_contact *c = &gt9xx->contacts[id];
+	int dz = READ_ONCE(gt9xx->deadzone) << GOODIX_FILTER_SHIFT;
+	int h = READ_ONCE(gt9xx->hysteresis);
+	int nx = *x << GOODIX_FILTER_SHIFT;
+	int ny = *y << GOODIX_FILTER_SHIFT;
+	int ox = (c->x + (1 << (GOODIX_FILTER_SHIFT - 1))) >> GOODIX_FILTER_SHIFT;
+	int oy = (c->y + (1 << (GOODIX_FILTER_SHIFT - 1))) >> GOODIX_FILTER_SHIFT;
+	bool new_contact = !test_bit(id, &gt9xx->active_slots);
+
+	if (new_contact) {
+		/* 新按下的点 */
+		c->x = nx;
+		c->y = ny;
+		c->moving = false;
+	} else if (!c->moving) {
+		/* 还在死区内,保持按下时的位置 */
+		if (abs(nx - c->x) > dz || abs(ny - c->y) > dz) {
+			c->moving = true;
+			c->x = goodix_gt9xx_hysteresis(c->x, nx, h);
+			c->y = goodix_gt9xx_hysteresis(c->y, ny, h);
+		}
+	} else {
+		c->x = goodix_gt9xx_hysteresis(c->x, nx, h);
+		c->y = goodix_gt9xx_hysteresis(c->y, ny, h);
+	}
+
+	*x = (c->x + (1 << (GOODIX_FILTER_SHIFT - 1))) >> GOODIX_FILTER_SHIFT;
+	*y = (c->y + (1 << (GOODIX_FILTER_SHIFT - 1))) >> GOODIX_FILTER_SHIFT;
+	return new_contact || *x != ox || *y != oy;
+}
+
+/* 速度的一次估计: 位移(1/16像素)*1000/时间(us) */
+static int goodix_gt9xx_velocity(int v, int d, int dt_us)
+{
+	return (v + d * 1000 / dt_us) / 2;
+}
+
+/*
+ * 运动预测,在滤波之后调用
+ * *x,*y输入为滤波后的实际位置,输出预测位置,超出屏幕时截断
+ */
+static void goodix_gt9xx_ts_predict(struct goodix_gt9xx_dev *gt9xx,
+			int id, bool new_contact, int *x, int *y)
+{
+	struct goodix_contact *c = &gt9xx->contacts[id];
+	int ms = READ_ONCE(gt9xx->predict_ms);
+	ktime_t now = gt9xx->irq_time;
+	s64 dt_us = ktime_us_delta(now, c->t);
+	s64 v2 = (s64)c->vx * c->vx + (s64)c->vy * c->vy;
+	s64 nv2;
+	int h, nx, ny;
+
+	if (new_contact || dt_us <= 0 || dt_us > GOODIX_PREDICT_GAP_US) {
+		c->vx = 0;
+		c->vy = 0;
+	} else {
+		c->vx = goodix_gt9xx_velocity(c->vx, c->x - c->px, (int)dt_us);
+		c->vy = goodix_gt9xx_velocity(c->vy, c->y - c->py, (int)dt_us);
+	}
+	c->px = c->x;
+	c->py = c->y;
+	c->t = now;
+
+	if (!ms)
+		return;
+
+	/* 外推时长h,单位1/16毫秒;减速时手指多半要停下,缩短外推以免冲过头 */
+	h = ms << GOODIX_FILTER_SHIFT;
+	nv2 = (s64)c->vx * c->vx + (s64)c->vy * c->vy;
+	if (nv2 * GOODIX_PREDICT_DECEL_DEN < v2 * GOODIX_PREDICT_DECEL_NUM)
+		h = div64_s64((s64)h * nv2 * GOODIX_PREDICT_DECEL_DEN,
+					v2 * GOODIX_PREDICT_DECEL_NUM);
+
+	nx = (c->x + ((c->vx * h) >> GOODIX_FILTER_SHIFT) +
+				(1 << (GOODIX_FILTER_SHIFT - 1))) >> GOODIX_FILTER_SHIFT;
+	ny = (c->y + ((c->vy * h) >> GOODIX_FILTER_SHIFT) +
+				(1 << (GOODIX_FILTER_SHIFT - 1))) >> GOODIX_FILTER_SHIFT;
+	*x = clamp(nx, 0, (int)gt9xx->prop.max_x);
+	*y = clamp(ny, 0, (int)gt9xx->prop.max_y);
+}
+
+/*
+ * 预测设备上报本帧松开的触摸点: 先把位置拉回松开前的实际位置再松开,
+ * 应用看到的抬起位置与主设备相同
+ */
+static void goodix_gt9xx_ts_pred_release(struct goodix_gt9xx_dev *gt9xx,
+			unsigned long released)
+{
+	struct input_dev *pred = gt9xx->pred_input;
+	struct goodix_contact *c;
+	int id;
+
+	for_each_set_bit(id, &released, GOODIX_MAX_POINTS) {
+		c = &gt9xx->contacts[id];
+		input_mt_slot(pred, id);
+		touchscreen_report_pos(pred, &gt9xx->prop,
+					(c->x + (1 << (GOODIX_FILTER_SHIFT - 1))) >> GOODIX_FILTER_SHIFT,
+					(c->y + (1 << (GOODIX_FILTER_SHIFT - 1))) >> GOODIX_FILTER_SHIFT,
+					true);
+		input_mt_report_slot_state(pred, MT_TOOL_FINGER, false);
+	}
+}
+
+/* 读取并上报一帧触摸数据,返回触摸点数,坐标未更新或出错时返回负数 */
+static int goodix_gt9xx_ts_report(struct goodix_gt9xx_dev *gt9xx)
+{
+	struct input_dev *input = gt9xx->input;
+	struct input_dev *pred = gt9xx->pred_input;
+	unsigned long cur_slots = 0;	//本帧按下的触摸点id位图
 	int cur_touch = 0;				//当前触摸点数
-	int cur_ids[10] = {0};			//当前触摸点的id
-	u8 rdbuf[8 * 10] = {0};			//gt9147最大支持10点触摸
+	bool changed = false;			//主设备本帧位置有变化
+	bool pred_changed = false;		//预测设备本帧位置有变化
+	u8 *rdbuf = NULL;
 	int i, x, y, id;
+	s64 latency;
+
+	trace_goodix_thread_start(&gt9xx->client->dev,
+				goodix_gt9xx_since(gt9xx->irq_time));
+	gt9xx->bus_ns = 0;
 
 	/* 读取触摸点坐标信息 */
-	cur_touch = goodix_gt9xx_ts_get_points(gt9xx, rdbuf);
+	cur_touch = goodix_gt9xx_ts_get_points(gt9xx, &rdbuf);
 	if (cur_touch < 0)
-		goto out;
+		return cur_touch;
 
-	/* 上报触摸屏按下相关事件 */
+	/* 上报本帧按下的触摸点 */
 	for (i = 0; i < cur_touch; i++) {
 
-		u8 *buf = &rdbuf[i * 8];
-		id = buf[0];
+		u8 *buf = &rdbuf[i * GOODIX_POINT_SIZE];
+		id = buf[0] & 0x0F;
+		if (id >= gt9xx->max_support_points)
+			continue;
 		x = (buf[2] << 8) | buf[1];
 		y = (buf[4] << 8) | buf[3];
+		changed |= goodix_gt9xx_ts_filter(gt9xx, id, &x, &y);
+
+		input_mt_slot(input, id);
+		input_mt_report_slot_state(input, MT_TOOL_FINGER, true);
+		touchscreen_report_pos(input, &gt9xx->prop, x, y, true);
+
+		if (pred) {
+			struct goodix_contact *c = &gt9xx->contacts[id];
+			bool new_contact = !test_bit(id, &gt9xx->active_slots);
+
+			goodix_gt9xx_ts_predict(gt9xx, id, new_contact, &x, &y);
+			pred_changed |= new_contact || x != c->rx || y != c->ry;
+			c->rx = x;
+			c->ry = y;
+			input_mt_slot(pred, id);
+			input_mt_report_slot_state(pred, MT_TOOL_FINGER, true);
+			touchscreen_report_pos(pred, &gt9xx->prop, x, y, true);
+		}
+		__set_bit(id, &cur_slots);
+	}
 
-		input_mt_slot(gt9xx->input, id);
-		input_mt_report_slot_state(gt9xx->input, MT_TOOL_FINGER, true);
-		input_report_abs(gt9xx->input, ABS_MT_POSITION_X, x);
-		input_report_abs(gt9xx->input, ABS_MT_POSITION_Y, y);
-		cur_ids[i] = id;
+	/*
+	 * 本帧没有上报的slot由INPUT_MT_DROP_UNUSED自动松开,并做单点模拟.
+	 * 位置和按下/松开都没有变化时input核心不会产生事件,但MSC_TIMESTAMP
+	 * 总会被传递,这时不上报时间戳和SYN_REPORT,长按时不唤醒evdev读者.
+	 * input_mt_sync_frame每帧都要调用,否则下一帧无法判断哪些slot未上报
+	 */
+	if (cur_slots != gt9xx->active_slots)
+		changed = pred_changed = true;
+	input_mt_sync_frame(input);
+	if (changed) {
+		goodix_gt9xx_ts_timestamp(gt9xx, input);
+		input_sync(input);
 	}
 
-	/* 上报触摸屏松开相关事件 */
-	for (i = 0; i < pre_touch; i++) {
+	if (pred) {
+		goodix_gt9xx_ts_pred_release(gt9xx, gt9xx->active_slots & ~cur_slots);
+		input_mt_sync_frame(pred);
+		if (pred_changed) {
+			goodix_gt9xx_ts_timestamp(gt9xx, pred);
+			input_sync(pred);
+		}
+	}
+	gt9xx->active_slots = cur_slots;
 
-		int j;
-		for (j = 0; j < cur_touch; j++) {
+	latency = goodix_gt9xx_since(gt9xx->irq_time);
+	trace_goodix_input_sync(&gt9xx->client->dev, cur_touch, latency, gt9xx->bus_ns);
+	goodix_gt9xx_hist_add(&gt9xx->lat_hist, latency);
+	goodix_gt9xx_hist_add(&gt9xx->bus_hist, gt9xx->bus_ns);
 
-			if (pre_ids[i] == cur_ids[j])
-				break;
-		}
+	return cur_touch;
+}
 
-		if (j == cur_touch) {	//表示当前触摸点中不存在这个pre_ids[i]id,表示它已经松开了
-			input_mt_slot(gt9xx->input, pre_ids[i]);
-			input_mt_report_slot_state(gt9xx->input, MT_TOOL_FINGER, false);
-		}
+static irqreturn_t goodix_gt9xx_ts_isr(int irq, void *dev_id)
+{
+	struct goodix_gt9xx_dev *gt9xx = dev_id;
+	int touch;
+
+	mutex_lock(&gt9xx->lock);
+	touch = goodix_gt9xx_ts_report(gt9xx);
+	if (touch > 0 && gt9xx->poll_on_touch && !gt9xx->polling) {
+		/* 有手指按下,关中断改为定时轮询,在线程中只能用nosync版本 */
+		disable_irq_nosync(irq);
+		gt9xx->polling = true;
+		gt9xx->poll_idle = 0;
+		hrtimer_start(&gt9xx->poll_timer, gt9xx->poll_period, HRTIMER_MODE_REL);
 	}
+	mutex_unlock(&gt9xx->lock);
 
-	input_mt_report_pointer_emulation(gt9xx->input, true);
-	input_sync(gt9xx->input);
+	return IRQ_HANDLED;
+}
 
-	for (i = 0; i < cur_touch; i++)
-		pre_ids[i] = cur_ids[i];
-	pre_touch = cur_touch;
+static enum hrtimer_restart goodix_gt9xx_ts_poll_timer(struct hrtimer *timer)
+{
+	struct goodix_gt9xx_dev *gt9xx = container_of(timer,
+				struct goodix_gt9xx_dev, poll_timer);
 
-out:
-	return IRQ_HANDLED;
+	/* 定时器到期时刻即采样时刻 */
+	gt9xx->irq_time = ktime_get();
+	queue_work(system_highpri_wq, &gt9xx->poll_work);
+	return HRTIMER_NORESTART;
+}
+
+static void goodix_gt9xx_ts_poll_work(struct work_struct *work)
+{
+	struct goodix_gt9xx_dev *gt9xx = container_of(work,
+				struct goodix_gt9xx_dev, poll_work);
+	int irq = gt9xx->client->irq;
+	int touch;
+
+	mutex_lock(&gt9xx->lock);
+	if (!gt9xx->polling)
+		goto unlock;
+
+	/* 芯片还没有产生新坐标时状态位0x80为0,这是轮询的正常情况 */
+	touch = goodix_gt9xx_ts_report(gt9xx);
+	if (touch > 0)
+		gt9xx->poll_idle = 0;
+	else if (touch < 0)
+		gt9xx->poll_idle++;
+
+	if (irq > 0 && (touch == 0 || gt9xx->poll_idle > GOODIX_POLL_IDLE_MAX)) {
+		/* 手指全部松开,恢复中断 */
+		gt9xx->polling = false;
+		enable_irq(irq);
+	} else {
+		hrtimer_start(&gt9xx->poll_timer, gt9xx->poll_period, HRTIMER_MODE_REL);
+	}
+
+unlock:
+	mutex_unlock(&gt9xx->lock);
+}
+
+/* 按芯片的坐标上报周期初始化轮询定时器 */
+static void goodix_gt9xx_ts_poll_init(struct goodix_gt9xx_dev *gt9xx)
+{
+	struct i2c_client *client = gt9xx->client;
+
+	gt9xx->poll_on_touch = of_property_read_bool(client->dev.of_node,
+				"goodix,poll-on-touch");
+
+	hrtimer_init(&gt9xx->poll_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	gt9xx->poll_timer.function = goodix_gt9xx_ts_poll_timer;
+	INIT_WORK(&gt9xx->poll_work, goodix_gt9xx_ts_poll_work);
+}
+
+/* 停止轮询,返回停止前是否在轮询 */
+static bool goodix_gt9xx_ts_poll_stop(struct goodix_gt9xx_dev *gt9xx)
+{
+	bool polling;
+
+	mutex_lock(&gt9xx->lock);
+	polling = gt9xx->polling;
+	gt9xx->polling = false;
+	mutex_unlock(&gt9xx->lock);
+
+	/* work和定时器互相启动,按顺序各取消一次后都不会再被启动 */
+	cancel_work_sync(&gt9xx->poll_work);
+	hrtimer_cancel(&gt9xx->poll_timer);
+	cancel_work_sync(&gt9xx->poll_work);
+
+	return polling;
 }
 
 static int goodix_gt9xx_ts_irq(struct goodix_gt9xx_dev *gt9xx)
 {
 	struct i2c_client *client = gt9xx->client;
+	unsigned long trigger;
 	int ret;
 
-	/* 注册中断服务函数 */
+	/* 触发方式以设备树为准,没有指定时用下降沿 */
+	trigger = irq_get_trigger_type(client->irq);
+	if (!trigger)
+		trigger = IRQF_TRIGGER_FALLING;
+
+	/* 注册中断服务函数,芯片配置完成前不使能 */
+	irq_set_status_flags(client->irq, IRQ_NOAUTOEN);
 	ret = devm_request_threaded_irq(&client->dev, client->irq,
-				NULL, goodix_gt9xx_ts_isr, IRQF_TRIGGER_FALLING | IRQF_ONESHOT,
+				goodix_gt9xx_ts_hardirq, goodix_gt9xx_ts_isr, trigger | IRQF_ONESHOT,
 				client->name, gt9xx);
 	if (ret) {
 		dev_err(&client->dev, "Failed to request touchscreen IRQ.\n");
@@ -407,12 +1079,257 @@ static int goodix_gt9xx_ts_irq(struct goodix_gt9xx_dev *gt9xx)
 	return 0;
 }
 
+/*
+ * debugfs: /sys/kernel/debug/goodix_gt9xx-<设备名>/histograms
+ * 读: 两个直方图;写任意内容: 清零
+ */
+static void goodix_gt9xx_hist_show(struct seq_file *m, const char *name,
+			const struct goodix_hist *h)
+{
+	int i;
+
+	seq_printf(m, "%s: n=%u avg=%lluus max=%lluus\n", name, h->n,
+				h->n ? div_u64(div_u64(h->sum_ns, h->n), NSEC_PER_USEC) : 0,
+				div_u64(h->max_ns, NSEC_PER_USEC));
+	for (i = 0; i < GOODIX_HIST_BINS; i++) {
+		if (!h->count[i])
+			continue;
+		seq_printf(m, "  [%7lu, %7lu)us %u\n", i ? 1UL << i : 0UL,
+					2UL << i, h->count[i]);
+	}
+}
+
+static int goodix_gt9xx_hist_seq_show(struct seq_file *m, void *v)
+{
+	struct goodix_gt9xx_dev *gt9xx = m->private;
+
+	mutex_lock(&gt9xx->lock);
+	goodix_gt9xx_hist_show(m, "irq_to_sync", &gt9xx->lat_hist);
+	goodix_gt9xx_hist_show(m, "i2c_per_report", &gt9xx->bus_hist);
+	mutex_unlock(&gt9xx->lock);
+	return 0;
+}
+
+static int goodix_gt9xx_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, goodix_gt9xx_hist_seq_show, inode->i_private);
+}
+
+static ssize_t goodix_gt9xx_hist_write(struct file *file,
+			const char __user *buf, size_t count, loff_t *ppos)
+{
+	struct goodix_gt9xx_dev *gt9xx = file_inode(file)->i_private;
+
+	mutex_lock(&gt9xx->lock);
+	memset(&gt9xx->lat_hist, 0, sizeof(gt9xx->lat_hist));
+	memset(&gt9xx->bus_hist, 0, sizeof(gt9xx->bus_hist));
+	mutex_unlock(&gt9xx->lock);
+	return count;
+}
+
+static const struct file_operations goodix_gt9xx_hist_fops = {
+	.owner		= THIS_MODULE,
+	.open		= goodix_gt9xx_hist_open,
+	.read		= seq_read,
+	.write		= goodix_gt9xx_hist_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+/*
+ * 芯片睡眠: 关中断、停止轮询,松开所有触摸点,INT拉低后写睡眠命令
+ * 睡眠期间INT作为输出,不能响应中断
+ */
+static void goodix_gt9xx_ts_sleep(struct goodix_gt9xx_dev *gt9xx)
+{
+	struct i2c_client *client = gt9xx->client;
+	u8 cmd = GOODIX_CMD_SLEEP;
+
+	if (gt9xx->sleeping)
+		return;
+
+	if (client->irq > 0)
+		disable_irq(client->irq);
+	/* 正在轮询时中断已被轮询模式关闭,这里抵消那一次 */
+	if (goodix_gt9xx_ts_poll_stop(gt9xx) && client->irq > 0)
+		enable_irq(client->irq);
+
+	mutex_lock(&gt9xx->lock);
+	gt9xx->active_slots = 0;
+	input_mt_sync_frame(gt9xx->input);
+	input_sync(gt9xx->input);
+	if (gt9xx->pred_input) {
+		input_mt_sync_frame(gt9xx->pred_input);
+		input_sync(gt9xx->pred_input);
+	}
+
+	gpio_direction_output(gt9xx->irq_gpio, 0);
+	usleep_range(5000, 6000);
+	if (goodix_gt9xx_ts_write(gt9xx, GOODIX_REG_COMMAND, &cmd, 1))
+		dev_warn(&client->dev, "Failed to enter sleep.\n");
+	msleep(58);
+	gt9xx->sleeping = true;
+	mutex_unlock(&gt9xx->lock);
+}
+
+/* 唤醒: INT先拉高,再按复位时的时序拉低后转为输入,不需要重新写配置 */
+static void goodix_gt9xx_ts_wake(struct goodix_gt9xx_dev *gt9xx)
+{
+	struct i2c_client *client = gt9xx->client;
+	u8 state = 0;
+
+	mutex_lock(&gt9xx->lock);
+	if (!gt9xx->sleeping) {
+		mutex_unlock(&gt9xx->lock);
+		return;
+	}
+
+	gpio_direction_output(gt9xx->irq_gpio, 1);
+	usleep_range(2000, 5000);
+	goodix_gt9xx_ts_int_sync(gt9xx);
+
+	goodix_gt9xx_ts_write(gt9xx, GOODIX_READ_COOR_ADDR, &state, 1);
+	gt9xx->last_touch = 0;
+	gt9xx->sleeping = false;
+
+	if (client->irq <= 0) {
+		gt9xx->polling = true;
+		hrtimer_start(&gt9xx->poll_timer, gt9xx->poll_period, HRTIMER_MODE_REL);
+	}
+	mutex_unlock(&gt9xx->lock);
+
+	if (client->irq > 0)
+		enable_irq(client->irq);
+}
+
+static void goodix_gt9xx_ts_blank_work(struct work_struct *work)
+{
+	struct goodix_gt9xx_dev *gt9xx = container_of(work,
+				struct goodix_gt9xx_dev, blank_work);
+
+	if (!READ_ONCE(gt9xx->ready))
+		return;
+
+	if (READ_ONCE(gt9xx->blanked))
+		goodix_gt9xx_ts_sleep(gt9xx);
+	else
+		goodix_gt9xx_ts_wake(gt9xx);
+}
+
+/* fb通知在fb_blank()中调用,睡眠时序约120ms,放到work中执行 */
+static int goodix_gt9xx_ts_fb_notifier(struct notifier_block *nb,
+			unsigned long event, void *data)
+{
+	struct goodix_gt9xx_dev *gt9xx = container_of(nb,
+				struct goodix_gt9xx_dev, fb_notif);
+	struct fb_event *evdata = data;
+	int blank;
+
+	if (event != FB_EVENT_BLANK || !evdata || !evdata->data)
+		return NOTIFY_DONE;
+	if (gt9xx->fb_index >= 0 && evdata->info->node != gt9xx->fb_index)
+		return NOTIFY_DONE;
+
+	blank = *(int *)evdata->data;
+	WRITE_ONCE(gt9xx->blanked, blank != FB_BLANK_UNBLANK);
+	schedule_work(&gt9xx->blank_work);
+	return NOTIFY_OK;
+}
+
+/*
+ * 复位并配置芯片,完成后使能中断(或开始轮询)
+ * 在probe之外异步执行,其它驱动和用户空间初始化不必等待触摸屏
+ */
+static void goodix_gt9xx_ts_init_work(struct work_struct *work)
+{
+	struct goodix_gt9xx_dev *gt9xx = container_of(work,
+				struct goodix_gt9xx_dev, init_work);
+	struct i2c_client *client = gt9xx->client;
+	u8 rate;
+	int ret;
+
+	mutex_lock(&gt9xx->lock);
+
+	/* 复位GT9xx触摸芯片 */
+	goodix_gt9xx_ts_reset(gt9xx);
+	msleep(5);
+
+	/* 初始化GT9xx */
+	ret = goodix_gt9xx_ts_load_cfg(gt9xx, gt9xx->chip_data);
+	if (!ret)
+		ret = goodix_gt9xx_ts_cfg(gt9xx);
+	if (ret) {
+		mutex_unlock(&gt9xx->lock);
+		dev_err(&client->dev, "Failed to init controller: %d\n", ret);
+		return;
+	}
+
+	/* 轮询周期等于芯片的坐标上报周期 */
+	rate = gt9xx->cfg[GOODIX_CFG_OFFSET(GOODIX_REG_REFRESH_RATE)];
+	gt9xx->poll_period = ms_to_ktime((rate & 0x0F) + 5);
+	gt9xx->ready = true;
+
+	if (client->irq > 0) {
+		enable_irq(client->irq);
+	} else {
+		dev_info(&client->dev, "no IRQ, polling every %lld ms.\n",
+					ktime_to_ms(gt9xx->poll_period));
+		gt9xx->polling = true;
+		hrtimer_start(&gt9xx->poll_timer, gt9xx->poll_period, HRTIMER_MODE_REL);
+	}
+	mutex_unlock(&gt9xx->lock);
+
+	/* 初始化期间显示屏已关闭 */
+	if (READ_ONCE(gt9xx->blanked))
+		schedule_work(&gt9xx->blank_work);
+}
+
+/*
+ * 注册上报预测位置的input设备,坐标范围、翻转和XY交换与主设备相同.
+ * 预测是可选的,单独一个设备,不需要预测的应用不受影响
+ */
+static int goodix_gt9xx_ts_pred_init(struct goodix_gt9xx_dev *gt9xx)
+{
+	struct device *dev = &gt9xx->client->dev;
+	struct input_dev *pred;
+	int ret;
+
+	pred = devm_input_allocate_device(dev);
+	if (!pred)
+		return -ENOMEM;
+
+	pred->name = "Goodix GT9xx TouchScreen (predicted)";
+	pred->id.bustype = BUS_I2C;
+	input_set_abs_params(pred, ABS_MT_POSITION_X, 0,
+				input_abs_get_max(gt9xx->input, ABS_MT_POSITION_X), 0, 0);
+	input_set_abs_params(pred, ABS_MT_POSITION_Y, 0,
+				input_abs_get_max(gt9xx->input, ABS_MT_POSITION_Y), 0, 0);
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 6, 0)
+	input_set_capability(pred, EV_MSC, MSC_TIMESTAMP);
+#endif
+
+	ret = input_mt_init_slots(pred, gt9xx->max_support_points,
+				INPUT_MT_DIRECT | INPUT_MT_DROP_UNUSED);
+	if (ret)
+		return ret;
+
+	ret = input_register_device(pred);
+	if (ret) {
+		dev_err(dev, "Failed to register prediction input device.\n");
+		return ret;
+	}
+	gt9xx->pred_input = pred;
+	return 0;
+}
+
 static int goodix_gt9xx_ts_probe(struct i2c_client *client,
 			const struct i2c_device_id *id)
 {
 	struct goodix_gt9xx_dev *gt9xx;
 	const struct goodix_i2c_chip_data *chip_data;
 	struct input_dev *input;
+	u32 fb_index;
+	char name[48];
 	int ret;
 
 	/* 实例化一个struct goodix_gt9xx_dev对象 */
@@ -423,27 +1340,50 @@ static int goodix_gt9xx_ts_probe(struct i2c_client *client,
 	}
 
 	gt9xx->client = client;
+	mutex_init(&gt9xx->lock);
+	INIT_WORK(&gt9xx->init_work, goodix_gt9xx_ts_init_work);
+	INIT_WORK(&gt9xx->blank_work, goodix_gt9xx_ts_blank_work);
+
+	/* 读缓冲区不能放在栈上或与其它成员共享cache行,单独分配 */
+	gt9xx->rbuf = devm_kzalloc(&client->dev, GOODIX_RBUF_LEN, GFP_KERNEL);
+	gt9xx->cfg = devm_kzalloc(&client->dev, GOODIX_CFG_CSM_LEN, GFP_KERNEL);
+	if (!gt9xx->rbuf || !gt9xx->cfg)
+		return -ENOMEM;
 
-	/* 获取gt9147、gt9271不同IC对应的信息 */
-	chip_data = of_device_get_match_data(&client->dev);
-	gt9xx->max_support_points = chip_data->max_support_points;
-
-	/* 复位GT9xx触摸芯片 */
-	ret = goodix_gt9xx_ts_reset(gt9xx);
-	if (ret)
-		return ret;
-
-	msleep(5);
+	gt9xx->regmap = devm_regmap_init_i2c(client, &goodix_regmap_config);
+	if (IS_ERR(gt9xx->regmap)) {
+		dev_err(&client->dev, "Failed to init regmap.\n");
+		return PTR_ERR(gt9xx->regmap);
+	}
 
-	/* 初始化GT9xx */
-	ret = chip_data->chip_cfg(gt9xx);
+	/* 获取gt9147、gt9271、gt911不同IC对应的信息 */
+	chip_data = of_device_get_match_data(&client->dev);
+	if (!chip_data && id)
+		chip_data = (const struct goodix_i2c_chip_data *)id->driver_data;
+	if (!chip_data)
+		return -ENODEV;
+	gt9xx->chip_data = chip_data;
+	gt9xx->max_support_points = min(chip_data->max_support_points, GOODIX_MAX_POINTS);
+
+	/* 滤波参数,设备树可以修改默认值 */
+	gt9xx->deadzone = GOODIX_DEF_DEADZONE;
+	gt9xx->hysteresis = GOODIX_DEF_HYSTERESIS;
+	of_property_read_u32(client->dev.of_node, "goodix,deadzone", &gt9xx->deadzone);
+	of_property_read_u32(client->dev.of_node, "goodix,hysteresis", &gt9xx->hysteresis);
+	/* 与sysfs的取值范围一致,左移GOODIX_FILTER_SHIFT后也不会溢出 */
+	gt9xx->deadzone = min_t(u32, gt9xx->deadzone, U8_MAX);
+	gt9xx->hysteresis = min_t(u32, gt9xx->hysteresis, U8_MAX);
+	of_property_read_u32(client->dev.of_node, "goodix,predict-ms", &gt9xx->predict_ms);
+	gt9xx->predict_ms = min_t(u32, gt9xx->predict_ms, GOODIX_PREDICT_MAX_MS);
+	if (chip_data->cfg)
+		memcpy(gt9xx->cfg, chip_data->cfg, GOODIX_CFG_CSM_LEN);
+
+	/* 获取复位、中断管脚,复位时序在init_work中完成 */
+	ret = goodix_gt9xx_ts_get_gpio(gt9xx);
 	if (ret)
 		return ret;
 
-	/* 申请、注册中断服务函数 */
-	ret = goodix_gt9xx_ts_irq(gt9xx);
-	if (ret)
-		return ret;
+	goodix_gt9xx_ts_poll_init(gt9xx);
 
 	/* 注册input设备 */
 	input = devm_input_allocate_device(&client->dev);
@@ -460,9 +1400,15 @@ static int goodix_gt9xx_ts_probe(struct i2c_client *client,
 				0, chip_data->abs_x_max, 0, 0);
 	input_set_abs_params(input, ABS_MT_POSITION_Y,
 				0, chip_data->abs_y_max, 0, 0);
+	/* 设备树touchscreen-size-x/y等属性可以覆盖默认值 */
+	touchscreen_parse_properties(input, true, &gt9xx->prop);
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 6, 0)
+	input_set_capability(input, EV_MSC, MSC_TIMESTAMP);
+#endif
 
 	ret = input_mt_init_slots(input, gt9xx->max_support_points,
-				INPUT_MT_DIRECT);
+				INPUT_MT_DIRECT | INPUT_MT_DROP_UNUSED);
 	if (ret) {
 		dev_err(&client->dev, "Failed to init MT slots.\n");
 		return ret;
@@ -472,50 +1418,144 @@ static int goodix_gt9xx_ts_probe(struct i2c_client *client,
 	if (ret)
 		return ret;
 
+	if (gt9xx->predict_ms) {
+		ret = goodix_gt9xx_ts_pred_init(gt9xx);
+		if (ret)
+			return ret;
+	}
+
+	/* 申请、注册中断服务函数,没有中断线时使用轮询模式 */
+	if (client->irq > 0) {
+		ret = goodix_gt9xx_ts_irq(gt9xx);
+		if (ret)
+			return ret;
+	}
+
 	i2c_set_clientdata(client, gt9xx);
+
+	ret = devm_device_add_group(&client->dev, &goodix_gt9xx_attr_group);
+	if (ret)
+		dev_warn(&client->dev, "Failed to create sysfs attributes.\n");
+
+	/* 跟随显示屏开关 */
+	gt9xx->fb_index = -1;
+	if (!of_property_read_u32(client->dev.of_node, "goodix,fb-index", &fb_index))
+		gt9xx->fb_index = fb_index;
+	gt9xx->fb_notif.notifier_call = goodix_gt9xx_ts_fb_notifier;
+	ret = fb_register_client(&gt9xx->fb_notif);
+	if (ret)
+		dev_warn(&client->dev, "Failed to register fb notifier.\n");
+
+	snprintf(name, sizeof(name), "goodix_gt9xx-%s", dev_name(&client->dev));
+	gt9xx->debugfs = debugfs_create_dir(name, NULL);
+	debugfs_create_file("histograms", 0644, gt9xx->debugfs, gt9xx,
+				&goodix_gt9xx_hist_fops);
+
+	schedule_work(&gt9xx->init_work);
 	return 0;
 }
 
 static int goodix_gt9xx_ts_remove(struct i2c_client *client)
 {
 	struct goodix_gt9xx_dev *gt9xx = i2c_get_clientdata(client);
+
+	fb_unregister_client(&gt9xx->fb_notif);
+	debugfs_remove_recursive(gt9xx->debugfs);
+	cancel_work_sync(&gt9xx->init_work);
+	cancel_work_sync(&gt9xx->blank_work);
+
+	/* 先关中断,防止松开前又进入轮询 */
+	if (client->irq > 0)
+		disable_irq(client->irq);
+	goodix_gt9xx_ts_poll_stop(gt9xx);
+
+	if (gt9xx->pred_input)
+		input_unregister_device(gt9xx->pred_input);
 	input_unregister_device(gt9xx->input);
 	return 0;
 }
 
+static int __maybe_unused goodix_gt9xx_ts_suspend(struct device *dev)
+{
+	struct goodix_gt9xx_dev *gt9xx = dev_get_drvdata(dev);
+
+	cancel_work_sync(&gt9xx->blank_work);
+	if (gt9xx->ready)
+		goodix_gt9xx_ts_sleep(gt9xx);
+	return 0;
+}
+
+static int __maybe_unused goodix_gt9xx_ts_resume(struct device *dev)
+{
+	struct goodix_gt9xx_dev *gt9xx = dev_get_drvdata(dev);
+
+	/* 显示屏仍然关闭时保持睡眠 */
+	if (gt9xx->ready && !READ_ONCE(gt9xx->blanked))
+		goodix_gt9xx_ts_wake(gt9xx);
+	return 0;
+}
+
+static SIMPLE_DEV_PM_OPS(goodix_gt9xx_ts_pm_ops,
+			goodix_gt9xx_ts_suspend, goodix_gt9xx_ts_resume);
+
 static const struct goodix_i2c_chip_data goodix_gt9147_data = {
 	.max_support_points = 5,
 	.abs_x_max = 800,		//以4.3寸800*480屏幕为例
 	.abs_y_max = 480,		//如果换成4.3寸480*272,这里要改,然后配置表也要改
-	.chip_cfg = goodix_gt9147_cfg,
+	.cfg = gt9147_cfg_data,
+	.cfg_name = GOODIX_GT9147_CFG_NAME,
 };
 
 static const struct goodix_i2c_chip_data goodix_gt9271_data = {
 	.max_support_points = 10,
 	.abs_x_max = 1280,
 	.abs_y_max = 800,
-	.chip_cfg = goodix_gt9271_cfg,
+	.cfg = gt9271_cfg_data,
+	.cfg_name = GOODIX_GT9271_CFG_NAME,
+};
+
+/* GT911没有内置配置,使用配置文件或芯片中已有的配置 */
+static const struct goodix_i2c_chip_data goodix_gt911_data = {
+	.max_support_points = 5,
+	.abs_x_max = 800,
+	.abs_y_max = 480,
+	.cfg = NULL,
+	.cfg_name = GOODIX_GT911_CFG_NAME,
 };
 
 static const struct of_device_id goodix_gt9xx_of_match[] = {
 	{ .compatible = "goodix,gt9147", .data = &goodix_gt9147_data },
 	{ .compatible = "goodix,gt9271", .data = &goodix_gt9271_data },
+	{ .compatible = "goodix,gt911", .data = &goodix_gt911_data },
 	{ /* sentinel */ }
 };
 MODULE_DEVICE_TABLE(of, goodix_gt9xx_of_match);
 
+static const struct i2c_device_id goodix_gt9xx_id[] = {
+	{ "gt9147", (kernel_ulong_t)&goodix_gt9147_data },
+	{ "gt9271", (kernel_ulong_t)&goodix_gt9271_data },
+	{ "gt911", (kernel_ulong_t)&goodix_gt911_data },
+	{ /* sentinel */ }
+};
+MODULE_DEVICE_TABLE(i2c, goodix_gt9xx_id);
+
 static struct i2c_driver goodix_gt9xx_ts_driver = {
 	.driver = {
 		.owner			= THIS_MODULE,
 		.name			= "goodix-gt9xx",
 		.of_match_table	= of_match_ptr(goodix_gt9xx_of_match),
+		.pm				= &goodix_gt9xx_ts_pm_ops,
 	},
 	.probe    = goodix_gt9xx_ts_probe,
 	.remove   = goodix_gt9xx_ts_remove,
+	.id_table = goodix_gt9xx_id,
 };
 
 module_i2c_driver(goodix_gt9xx_ts_driver);
 
 MODULE_AUTHOR("Deng Tao <773904075@qq.com>, ALIENTEK, Inc.");
-MODULE_DESCRIPTION("Goodix gt9147/gt9271 I2C Touchscreen Driver");
+MODULE_DESCRIPTION("Goodix gt9147/gt9271/gt911 I2C Touchscreen Driver");
 MODULE_LICENSE("GPL");
+MODULE_FIRMWARE(GOODIX_GT9147_CFG_NAME);
+MODULE_FIRMWARE(GOODIX_GT9271_CFG_NAME);
+MODULE_FIRMWARE(GOODIX_GT911_CFG_NAME);
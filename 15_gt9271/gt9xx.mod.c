@@ -1,33 +0,0 @@
-#include <linux/build-salt.h>
-#include <linux/module.h>
-#include <linux/vermagic.h>
-#include <linux/compiler.h>
-
-BUILD_SALT;
-
-MODULE_INFO(vermagic, VERMAGIC_STRING);
-MODULE_INFO(name, KBUILD_MODNAME);
-
-__visible struct module __this_module
-__attribute__((section(".gnu.linkonce.this_module"))) = {
-	.name = KBUILD_MODNAME,
-	.init = init_module,
-#ifdef CONFIG_MODULE_UNLOAD
-	.exit = cleanup_module,
-#endif
-	.arch = MODULE_ARCH_INIT,
-};
-
-#ifdef RETPOLINE
-MODULE_INFO(retpoline, "Y");
-#endif
-
-static const char __module_depends[]
-__used
-__attribute__((section(".modinfo"))) =
-"depends=";
-
-MODULE_ALIAS("of:N*T*Cgoodix,gt9147");
-MODULE_ALIAS("of:N*T*Cgoodix,gt9147C*");
-MODULE_ALIAS("of:N*T*Cgoodix,gt9271");
-MODULE_ALIAS("of:N*T*Cgoodix,gt9271C*");
@@ -0,0 +1,107 @@
+/*
+ * GT9xx触摸上报流程的tracepoint
+ *
+ * 一次上报: hardirq -> thread_start -> status_read(状态字节+预测的坐标)
+ *           -> points_read(点数多于预测时补读) -> clear_write -> input_sync
+ * 时间均为纳秒,bus_ns为i2c传输耗时,delay_ns/latency_ns从硬中断(或轮询定时器)开始计算.
+ * 使用: echo 1 > /sys/kernel/debug/tracing/events/goodix_gt9xx/enable
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM goodix_gt9xx
+
+#if !defined(_GT9XX_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _GT9XX_TRACE_H
+
+#include <linux/tracepoint.h>
+#include <linux/device.h>
+
+TRACE_EVENT(goodix_hardirq,
+	TP_PROTO(struct device *dev, int irq),
+	TP_ARGS(dev, irq),
+	TP_STRUCT__entry(
+		__string(dev, dev_name(dev))
+		__field(int, irq)
+	),
+	TP_fast_assign(
+		__assign_str(dev, dev_name(dev));
+		__entry->irq = irq;
+	),
+	TP_printk("%s irq=%d", __get_str(dev), __entry->irq)
+);
+
+TRACE_EVENT(goodix_thread_start,
+	TP_PROTO(struct device *dev, s64 delay_ns),
+	TP_ARGS(dev, delay_ns),
+	TP_STRUCT__entry(
+		__string(dev, dev_name(dev))
+		__field(s64, delay_ns)
+	),
+	TP_fast_assign(
+		__assign_str(dev, dev_name(dev));
+		__entry->delay_ns = delay_ns;
+	),
+	TP_printk("%s delay=%lldns", __get_str(dev), __entry->delay_ns)
+);
+
+DECLARE_EVENT_CLASS(goodix_xfer,
+	TP_PROTO(struct device *dev, u8 status, int len, s64 bus_ns, int ret),
+	TP_ARGS(dev, status, len, bus_ns, ret),
+	TP_STRUCT__entry(
+		__string(dev, dev_name(dev))
+		__field(u8, status)
+		__field(int, len)
+		__field(s64, bus_ns)
+		__field(int, ret)
+	),
+	TP_fast_assign(
+		__assign_str(dev, dev_name(dev));
+		__entry->status = status;
+		__entry->len = len;
+		__entry->bus_ns = bus_ns;
+		__entry->ret = ret;
+	),
+	TP_printk("%s status=0x%02x len=%d bus=%lldns ret=%d", __get_str(dev),
+		  __entry->status, __entry->len, __entry->bus_ns, __entry->ret)
+);
+
+DEFINE_EVENT(goodix_xfer, goodix_status_read,
+	TP_PROTO(struct device *dev, u8 status, int len, s64 bus_ns, int ret),
+	TP_ARGS(dev, status, len, bus_ns, ret)
+);
+
+DEFINE_EVENT(goodix_xfer, goodix_points_read,
+	TP_PROTO(struct device *dev, u8 status, int len, s64 bus_ns, int ret),
+	TP_ARGS(dev, status, len, bus_ns, ret)
+);
+
+DEFINE_EVENT(goodix_xfer, goodix_clear_write,
+	TP_PROTO(struct device *dev, u8 status, int len, s64 bus_ns, int ret),
+	TP_ARGS(dev, status, len, bus_ns, ret)
+);
+
+TRACE_EVENT(goodix_input_sync,
+	TP_PROTO(struct device *dev, int touch, s64 latency_ns, s64 bus_ns),
+	TP_ARGS(dev, touch, latency_ns, bus_ns),
+	TP_STRUCT__entry(
+		__string(dev, dev_name(dev))
+		__field(int, touch)
+		__field(s64, latency_ns)
+		__field(s64, bus_ns)
+	),
+	TP_fast_assign(
+		__assign_str(dev, dev_name(dev));
+		__entry->touch = touch;
+		__entry->latency_ns = latency_ns;
+		__entry->bus_ns = bus_ns;
+	),
+	TP_printk("%s touch=%d latency=%lldns bus=%lldns", __get_str(dev),
+		  __entry->touch, __entry->latency_ns, __entry->bus_ns)
+);
+
+#endif /* _GT9XX_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE gt9xx_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,635 @@
+/*
+ * 显存分配方式的DDR带宽测试
+ *
+ * 按不同的内存属性分配帧缓冲大小的缓冲区:
+ *   wc:       dma_alloc_wc,写合并(xlnx_vdmafb的默认方式)
+ *   coherent: dma_alloc_coherent
+ *   cached:   vmalloc的普通可缓存页 + dma_map_sg,每次交给DMA前显式同步缓存
+ *   reserved: 设备树memory-region指定的no-map保留内存,memremap为WC
+ * 分别测量CPU写、读、读改写、从普通内存memcpy以及缓存维护的吞吐量.
+ * 设备树中提供dmas = <...>, dma-names = "stream"时,还会在VDMA(或memcpy通道)
+ * 持续读内存的情况下重复测试,得到扫描输出对CPU访存的影响.
+ *
+ * 使用:
+ *   echo 1 > /sys/kernel/debug/fbmem_bench/run
+ *   cat /sys/kernel/debug/fbmem_bench/results     (CSV)
+ *
+ * 设备树示例:
+ *   fbmem_bench {
+ *       compatible = "custom,fbmem-bench";
+ *       memory-region = <&fb_reserved>;         可选
+ *       dmas = <&axi_vdma_1 0>;                 可选
+ *       dma-names = "stream";
+ *   };
+ */
+#include <linux/module.h>
+#include <linux/platform_device.h>
+#include <linux/of.h>
+#include <linux/of_reserved_mem.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/debugfs.h>
+#include <linux/uaccess.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/gfp.h>
+#include <linux/mm.h>
+#include <linux/scatterlist.h>
+#include <linux/io.h>
+#include <linux/sched.h>
+#include <linux/delay.h>
+
+static unsigned int size = 1280 * 800 * 3;
+module_param(size, uint, 0644);
+MODULE_PARM_DESC(size, "Buffer size in bytes, default one 1280x800 RGB888 frame");
+
+static unsigned int loops = 10;
+module_param(loops, uint, 0644);
+MODULE_PARM_DESC(loops, "Iterations per measurement");
+
+static unsigned int stream_width = 1280;
+module_param(stream_width, uint, 0644);
+MODULE_PARM_DESC(stream_width, "Width of the VDMA read stream in pixels");
+
+static unsigned int stream_height = 800;
+module_param(stream_height, uint, 0644);
+MODULE_PARM_DESC(stream_height, "Height of the VDMA read stream in lines");
+
+enum fbmem_mode {
+    FBMEM_WC,
+    FBMEM_COHERENT,
+    FBMEM_CACHED,
+    FBMEM_RESERVED,
+    FBMEM_NR_MODES,
+};
+
+static const char * const fbmem_mode_names[FBMEM_NR_MODES] = {
+    [FBMEM_WC]       = "wc",
+    [FBMEM_COHERENT] = "coherent",
+    [FBMEM_CACHED]   = "cached",
+    [FBMEM_RESERVED] = "reserved",
+};
+
+struct fbmem_buf {
+    void *virt;
+    dma_addr_t dma;
+    size_t size;
+    struct sg_table sgt;            /*cached模式按页映射,缓存维护逐段进行*/
+};
+
+#define FBMEM_RESULTS_SIZE  (16 * 1024)
+
+struct fbmem_bench_dev {
+    struct device *dev;
+    struct fbmem_buf bufs[FBMEM_NR_MODES];
+    void *src;                      /*memcpy的源,普通可缓存内存*/
+    phys_addr_t rmem_base;
+    size_t rmem_size;
+
+    /*读内存的DMA流,模拟扫描输出*/
+    struct dma_chan *stream;
+    struct fbmem_buf stream_buf;
+    struct dma_interleaved_template *stream_xt;
+    bool streaming;
+    atomic_t stream_done;
+    atomic_t stream_frames;
+
+    struct dentry *dir;
+    struct mutex lock;
+    char *results;
+    size_t results_len;
+};
+
+/*---------------------------------- 分配 ----------------------------------*/
+
+/*
+ * cached模式: alloc_pages_exact受MAX_ORDER限制最多4MB,放不下1920x1080x4等整帧,
+ * 改用vmalloc,再把各页组成sg表做流式DMA映射.CPU经vmalloc映射访问,
+ * 内存属性与线性映射相同(普通可缓存)
+ */
+static int fbmem_map_cached(struct device *dev, struct fbmem_buf *buf)
+{
+    unsigned int npages = buf->size >> PAGE_SHIFT;
+    struct page **pages;
+    unsigned int i;
+    int ret, nents;
+
+    pages = kvmalloc_array(npages, sizeof(*pages), GFP_KERNEL);
+    if (!pages)
+        return -ENOMEM;
+    for (i = 0; i < npages; i++)
+        pages[i] = vmalloc_to_page(buf->virt + ((size_t)i << PAGE_SHIFT));
+    ret = sg_alloc_table_from_pages(&buf->sgt, pages, npages, 0, buf->size, GFP_KERNEL);
+    kvfree(pages);
+    if (ret)
+        return ret;
+
+    /*双向映射,sync_for_device做clean,sync_for_cpu做invalidate都可测*/
+    nents = dma_map_sg(dev, buf->sgt.sgl, buf->sgt.orig_nents, DMA_BIDIRECTIONAL);
+    if (!nents) {
+        sg_free_table(&buf->sgt);
+        return -ENOMEM;
+    }
+    buf->sgt.nents = nents;
+    buf->dma = sg_dma_address(buf->sgt.sgl);
+    return 0;
+}
+
+static void fbmem_sync_for_device(struct device *dev, struct fbmem_buf *buf)
+{
+    dma_sync_sg_for_device(dev, buf->sgt.sgl, buf->sgt.orig_nents, DMA_BIDIRECTIONAL);
+}
+
+static void fbmem_sync_for_cpu(struct device *dev, struct fbmem_buf *buf)
+{
+    dma_sync_sg_for_cpu(dev, buf->sgt.sgl, buf->sgt.orig_nents, DMA_BIDIRECTIONAL);
+}
+
+static int fbmem_alloc(struct fbmem_bench_dev *fb, enum fbmem_mode mode)
+{
+    struct fbmem_buf *buf = &fb->bufs[mode];
+    struct device *dev = fb->dev;
+
+    buf->size = PAGE_ALIGN(size);
+    switch (mode) {
+    case FBMEM_WC:
+        buf->virt = dma_alloc_wc(dev, buf->size, &buf->dma, GFP_KERNEL);
+        break;
+    case FBMEM_COHERENT:
+        buf->virt = dma_alloc_coherent(dev, buf->size, &buf->dma, GFP_KERNEL);
+        break;
+    case FBMEM_CACHED:
+        buf->virt = vmalloc(buf->size);
+        if (!buf->virt)
+            break;
+        if (fbmem_map_cached(dev, buf)) {
+            vfree(buf->virt);
+            buf->virt = NULL;
+        }
+        break;
+    case FBMEM_RESERVED:
+        if (fb->rmem_size < buf->size)
+            break;
+        buf->virt = memremap(fb->rmem_base, buf->size, MEMREMAP_WC);
+        buf->dma = fb->rmem_base;
+        break;
+    default:
+        break;
+    }
+    if (!buf->virt)
+        return -ENOMEM;
+
+    memset(buf->virt, 0, buf->size);
+    if (mode == FBMEM_CACHED)
+        fbmem_sync_for_device(dev, buf);
+    return 0;
+}
+
+static void fbmem_free(struct fbmem_bench_dev *fb, enum fbmem_mode mode)
+{
+    struct fbmem_buf *buf = &fb->bufs[mode];
+    struct device *dev = fb->dev;
+
+    if (!buf->virt)
+        return;
+    switch (mode) {
+    case FBMEM_WC:
+        dma_free_wc(dev, buf->size, buf->virt, buf->dma);
+        break;
+    case FBMEM_COHERENT:
+        dma_free_coherent(dev, buf->size, buf->virt, buf->dma);
+        break;
+    case FBMEM_CACHED:
+        dma_unmap_sg(dev, buf->sgt.sgl, buf->sgt.orig_nents, DMA_BIDIRECTIONAL);
+        sg_free_table(&buf->sgt);
+        vfree(buf->virt);
+        break;
+    case FBMEM_RESERVED:
+        memunmap(buf->virt);
+        break;
+    default:
+        break;
+    }
+    buf->virt = NULL;
+}
+
+/*---------------------------------- 读流 ----------------------------------*/
+
+static int fbmem_stream_submit(struct fbmem_bench_dev *fb);
+static void fbmem_stream_exit(struct fbmem_bench_dev *fb);
+
+static void fbmem_stream_done(void *param)
+{
+    struct fbmem_bench_dev *fb = param;
+
+    atomic_inc(&fb->stream_frames);
+    if (READ_ONCE(fb->streaming))
+        fbmem_stream_submit(fb);
+    else
+        atomic_set(&fb->stream_done, 1);
+}
+
+/*
+ * 支持交错传输的通道(VDMA MM2S)按扫描输出的方式读整帧;
+ * 只支持memcpy的通道把缓冲区前半拷到后半,同样产生持续的读流量
+ */
+static int fbmem_stream_submit(struct fbmem_bench_dev *fb)
+{
+    struct dma_async_tx_descriptor *desc;
+    size_t half = fb->stream_buf.size / 2;
+
+    if (fb->stream_xt)
+        desc = dmaengine_prep_interleaved_dma(fb->stream, fb->stream_xt,
+                                              DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+    else
+        desc = dmaengine_prep_dma_memcpy(fb->stream, fb->stream_buf.dma + half,
+                                         fb->stream_buf.dma, half,
+                                         DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+    if (!desc)
+        return -EIO;
+    desc->callback = fbmem_stream_done;
+    desc->callback_param = fb;
+    if (dma_submit_error(dmaengine_submit(desc)))
+        return -EIO;
+    dma_async_issue_pending(fb->stream);
+    return 0;
+}
+
+static int fbmem_stream_start(struct fbmem_bench_dev *fb)
+{
+    atomic_set(&fb->stream_done, 0);
+    atomic_set(&fb->stream_frames, 0);
+    WRITE_ONCE(fb->streaming, true);
+    if (fbmem_stream_submit(fb)) {
+        WRITE_ONCE(fb->streaming, false);
+        return -EIO;
+    }
+    return 0;
+}
+
+static void fbmem_stream_stop(struct fbmem_bench_dev *fb)
+{
+    unsigned long timeout = jiffies + HZ / 2;
+
+    WRITE_ONCE(fb->streaming, false);
+    while (!atomic_read(&fb->stream_done) && time_before(jiffies, timeout))
+        msleep(1);
+    dmaengine_terminate_sync(fb->stream);
+}
+
+static int fbmem_stream_init(struct fbmem_bench_dev *fb)
+{
+    struct device *dev = fb->dev;
+    struct dma_interleaved_template *xt;
+    size_t line = stream_width * 3;
+
+    fb->stream = dma_request_chan(dev, "stream");
+    if (IS_ERR(fb->stream)) {
+        if (PTR_ERR(fb->stream) == -EPROBE_DEFER)
+            return -EPROBE_DEFER;
+        fb->stream = NULL;
+        return 0;       /*可选*/
+    }
+
+    fb->stream_buf.size = PAGE_ALIGN(line * stream_height);
+    fb->stream_buf.virt = dma_alloc_wc(dev, fb->stream_buf.size, &fb->stream_buf.dma, GFP_KERNEL);
+    if (!fb->stream_buf.virt) {
+        dma_release_channel(fb->stream);
+        fb->stream = NULL;
+        return -ENOMEM;
+    }
+
+    if (dma_has_cap(DMA_INTERLEAVE, fb->stream->device->cap_mask)) {
+        xt = devm_kzalloc(dev, sizeof(*xt) + sizeof(struct data_chunk), GFP_KERNEL);
+        if (!xt) {
+            fbmem_stream_exit(fb);
+            fb->stream = NULL;
+            return -ENOMEM;
+        }
+        xt->dir = DMA_MEM_TO_DEV;
+        xt->src_start = fb->stream_buf.dma;
+        xt->numf = stream_height;
+        xt->frame_size = 1;
+        xt->sgl[0].size = line;
+        xt->sgl[0].icg = 0;
+        xt->src_inc = true;
+        xt->src_sgl = true;
+        fb->stream_xt = xt;
+    }
+    dev_info(dev, "read stream on %s (%s)\n", dma_chan_name(fb->stream),
+             fb->stream_xt ? "interleaved" : "memcpy");
+    return 0;
+}
+
+static void fbmem_stream_exit(struct fbmem_bench_dev *fb)
+{
+    if (!fb->stream)
+        return;
+    dmaengine_terminate_sync(fb->stream);
+    dma_release_channel(fb->stream);
+    dma_free_wc(fb->dev, fb->stream_buf.size, fb->stream_buf.virt, fb->stream_buf.dma);
+}
+
+/*---------------------------------- 测试 ----------------------------------*/
+
+/*按32位字访问,四路展开,编译器不会合并成memset/memcpy*/
+static noinline void fbmem_write(void *p, size_t len, u32 val)
+{
+    u32 *d = p, *end = d + len / 4;
+
+    for (; d < end; d += 4) {
+        WRITE_ONCE(d[0], val);
+        WRITE_ONCE(d[1], val);
+        WRITE_ONCE(d[2], val);
+        WRITE_ONCE(d[3], val);
+    }
+}
+
+static noinline u32 fbmem_read(const void *p, size_t len)
+{
+    const u32 *s = p, *end = s + len / 4;
+    u32 a = 0, b = 0, c = 0, d = 0;
+
+    for (; s < end; s += 4) {
+        a += READ_ONCE(s[0]);
+        b += READ_ONCE(s[1]);
+        c += READ_ONCE(s[2]);
+        d += READ_ONCE(s[3]);
+    }
+    return a ^ b ^ c ^ d;
+}
+
+static noinline void fbmem_rmw(void *p, size_t len)
+{
+    u32 *d = p, *end = d + len / 4;
+
+    for (; d < end; d++)
+        WRITE_ONCE(*d, READ_ONCE(*d) ^ 0x01010101);
+}
+
+enum fbmem_test {
+    FBMEM_T_WRITE,
+    FBMEM_T_READ,
+    FBMEM_T_RMW,
+    FBMEM_T_MEMCPY,
+    FBMEM_T_WRITE_SYNC,         /*写后clean到DDR,即可缓存内存交给DMA前的实际写代价*/
+    FBMEM_T_SYNC_DEV,           /*只做clean*/
+    FBMEM_T_SYNC_CPU,           /*只做invalidate*/
+    FBMEM_NR_TESTS,
+};
+
+static const char * const fbmem_test_names[FBMEM_NR_TESTS] = {
+    [FBMEM_T_WRITE]      = "write",
+    [FBMEM_T_READ]       = "read",
+    [FBMEM_T_RMW]        = "rmw",
+    [FBMEM_T_MEMCPY]     = "memcpy",
+    [FBMEM_T_WRITE_SYNC] = "write+sync",
+    [FBMEM_T_SYNC_DEV]   = "sync_for_device",
+    [FBMEM_T_SYNC_CPU]   = "sync_for_cpu",
+};
+
+static volatile u32 fbmem_sink;
+
+static void fbmem_run_one(struct fbmem_bench_dev *fb, enum fbmem_mode mode,
+                          enum fbmem_test test, u64 *ns)
+{
+    struct fbmem_buf *buf = &fb->bufs[mode];
+    struct device *dev = fb->dev;
+    ktime_t start;
+    unsigned int i;
+
+    *ns = 0;
+    for (i = 0; i < loops; i++) {
+        /*缓存维护的测试需要先让缓存里有脏数据*/
+        if (test == FBMEM_T_SYNC_DEV)
+            fbmem_write(buf->virt, buf->size, i);
+
+        start = ktime_get();
+        switch (test) {
+        case FBMEM_T_WRITE:
+            fbmem_write(buf->virt, buf->size, i);
+            break;
+        case FBMEM_T_READ:
+            fbmem_sink = fbmem_read(buf->virt, buf->size);
+            break;
+        case FBMEM_T_RMW:
+            fbmem_rmw(buf->virt, buf->size);
+            break;
+        case FBMEM_T_MEMCPY:
+            memcpy(buf->virt, fb->src, buf->size);
+            break;
+        case FBMEM_T_WRITE_SYNC:
+            fbmem_write(buf->virt, buf->size, i);
+            fbmem_sync_for_device(dev, buf);
+            break;
+        case FBMEM_T_SYNC_DEV:
+            fbmem_sync_for_device(dev, buf);
+            break;
+        case FBMEM_T_SYNC_CPU:
+            fbmem_sync_for_cpu(dev, buf);
+            break;
+        default:
+            break;
+        }
+        *ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+        cond_resched();
+    }
+}
+
+static void fbmem_report(struct fbmem_bench_dev *fb, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    fb->results_len += vscnprintf(fb->results + fb->results_len,
+                                  FBMEM_RESULTS_SIZE - fb->results_len, fmt, args);
+    va_end(args);
+}
+
+static void fbmem_run_pass(struct fbmem_bench_dev *fb, bool stream)
+{
+    enum fbmem_mode mode;
+    enum fbmem_test test;
+    u64 ns;
+
+    for (mode = 0; mode < FBMEM_NR_MODES; mode++) {
+        if (!fb->bufs[mode].virt)
+            continue;
+        for (test = 0; test < FBMEM_NR_TESTS; test++) {
+            /*缓存维护只对可缓存的映射有意义*/
+            if (test >= FBMEM_T_WRITE_SYNC && mode != FBMEM_CACHED)
+                continue;
+            fbmem_run_one(fb, mode, test, &ns);
+            fbmem_report(fb, "%s,%s,%d,%zu,%u,%llu,%llu\n",
+                         fbmem_mode_names[mode], fbmem_test_names[test], stream,
+                         fb->bufs[mode].size, loops, ns,
+                         ns ? div64_u64((u64)fb->bufs[mode].size * loops * 1000, ns) : 0);
+        }
+    }
+}
+
+static int fbmem_run(struct fbmem_bench_dev *fb)
+{
+    enum fbmem_mode mode;
+    ktime_t start;
+    u64 ns;
+    int ret = 0;
+
+    fb->src = vmalloc(PAGE_ALIGN(size));
+    if (!fb->src)
+        return -ENOMEM;
+    memset(fb->src, 0x5a, PAGE_ALIGN(size));
+
+    for (mode = 0; mode < FBMEM_NR_MODES; mode++) {
+        if (fbmem_alloc(fb, mode))
+            dev_info(fb->dev, "%s: not available, skipped\n", fbmem_mode_names[mode]);
+    }
+
+    fb->results_len = 0;
+    fbmem_report(fb, "mode,test,stream,bytes,loops,ns,mb_per_s\n");
+    fbmem_run_pass(fb, false);
+
+    if (fb->stream) {
+        if (fbmem_stream_start(fb)) {
+            dev_err(fb->dev, "Failed to start read stream\n");
+            ret = -EIO;
+            goto out;
+        }
+        start = ktime_get();
+        fbmem_run_pass(fb, true);
+        ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+        fbmem_stream_stop(fb);
+        /*读流自身的带宽,用于确认测试期间DMA一直在运行*/
+        fbmem_report(fb, "stream,read,1,%zu,%u,%llu,%llu\n",
+                     fb->stream_xt ? fb->stream_buf.size : fb->stream_buf.size / 2,
+                     atomic_read(&fb->stream_frames), ns,
+                     ns ? div64_u64((u64)(fb->stream_xt ? fb->stream_buf.size :
+                                          fb->stream_buf.size / 2) *
+                                    atomic_read(&fb->stream_frames) * 1000, ns) : 0);
+    }
+
+out:
+    for (mode = 0; mode < FBMEM_NR_MODES; mode++)
+        fbmem_free(fb, mode);
+    vfree(fb->src);
+    fb->src = NULL;
+    return ret;
+}
+
+/*---------------------------------- debugfs ----------------------------------*/
+
+static ssize_t fbmem_run_write(struct file *file, const char __user *ubuf,
+                               size_t count, loff_t *ppos)
+{
+    struct fbmem_bench_dev *fb = file->private_data;
+    int ret;
+
+    mutex_lock(&fb->lock);
+    ret = fbmem_run(fb);
+    mutex_unlock(&fb->lock);
+    return ret ? ret : count;
+}
+
+static const struct file_operations fbmem_run_fops = {
+    .owner  = THIS_MODULE,
+    .open   = simple_open,
+    .write  = fbmem_run_write,
+    .llseek = noop_llseek,
+};
+
+static ssize_t fbmem_results_read(struct file *file, char __user *ubuf,
+                                  size_t count, loff_t *ppos)
+{
+    struct fbmem_bench_dev *fb = file->private_data;
+    ssize_t ret;
+
+    mutex_lock(&fb->lock);
+    ret = simple_read_from_buffer(ubuf, count, ppos, fb->results, fb->results_len);
+    mutex_unlock(&fb->lock);
+    return ret;
+}
+
+static const struct file_operations fbmem_results_fops = {
+    .owner  = THIS_MODULE,
+    .open   = simple_open,
+    .read   = fbmem_results_read,
+    .llseek = default_llseek,
+};
+
+/*---------------------------------- platform ----------------------------------*/
+
+static int fbmem_bench_probe(struct platform_device *pdev)
+{
+    struct device *dev = &pdev->dev;
+    struct fbmem_bench_dev *fb;
+    struct device_node *np;
+    struct reserved_mem *rmem;
+    int ret;
+
+    fb = devm_kzalloc(dev, sizeof(*fb), GFP_KERNEL);
+    if (!fb)
+        return -ENOMEM;
+    fb->dev = dev;
+    mutex_init(&fb->lock);
+    platform_set_drvdata(pdev, fb);
+
+    fb->results = devm_kzalloc(dev, FBMEM_RESULTS_SIZE, GFP_KERNEL);
+    if (!fb->results)
+        return -ENOMEM;
+
+    ret = dma_set_mask_and_coherent(dev, DMA_BIT_MASK(32));
+    if (ret)
+        return ret;
+
+    /*no-map保留内存(可选)*/
+    np = of_parse_phandle(dev->of_node, "memory-region", 0);
+    if (np) {
+        rmem = of_reserved_mem_lookup(np);
+        of_node_put(np);
+        if (rmem) {
+            fb->rmem_base = rmem->base;
+            fb->rmem_size = rmem->size;
+        }
+    }
+
+    ret = fbmem_stream_init(fb);
+    if (ret)
+        return ret;
+
+    fb->dir = debugfs_create_dir("fbmem_bench", NULL);
+    debugfs_create_file("run", 0200, fb->dir, fb, &fbmem_run_fops);
+    debugfs_create_file("results", 0444, fb->dir, fb, &fbmem_results_fops);
+
+    dev_info(dev, "fbmem bench ready, %u bytes per buffer\n", size);
+    return 0;
+}
+
+static int fbmem_bench_remove(struct platform_device *pdev)
+{
+    struct fbmem_bench_dev *fb = platform_get_drvdata(pdev);
+
+    debugfs_remove_recursive(fb->dir);
+    fbmem_stream_exit(fb);
+    return 0;
+}
+
+static const struct of_device_id fbmem_bench_of_match[] = {
+    { .compatible = "custom,fbmem-bench" },
+    { }
+};
+MODULE_DEVICE_TABLE(of, fbmem_bench_of_match);
+
+static struct platform_driver fbmem_bench_driver = {
+    .probe  = fbmem_bench_probe,
+    .remove = fbmem_bench_remove,
+    .driver = {
+        .name = "fbmem-bench",
+        .of_match_table = fbmem_bench_of_match,
+    },
+};
+module_platform_driver(fbmem_bench_driver);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Scanout buffer allocation attribute bandwidth benchmark");
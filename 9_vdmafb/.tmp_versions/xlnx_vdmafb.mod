@@ -1,3 +0,0 @@
-/home/lvd/workspace/drivers/9_vdmafb/xlnx_vdmafb.ko
-/home/lvd/workspace/drivers/9_vdmafb/xlnx_vdmafb.o
-
@@ -0,0 +1,767 @@
+/*
+ * fbcomp合成器守护进程
+ *
+ * fbcomp [-d /dev/fbN] [-s socket] [-b RRGGBB]
+ *
+ * 每帧只处理提交了损坏区域的部分:对每个屏幕损坏矩形,从完全覆盖它的最上层
+ * 不透明surface(没有则为背景色)开始,自下而上把相交的surface混合到后台缓冲区.
+ * 前后台缓冲区之间的差异由libvdmafb按前几帧的损坏区域补齐,之后在vblank翻页,
+ * 再通知提交者可以继续绘制.
+ *
+ * 编译: $(CROSS_COMPILE)gcc -O2 -mfpu=neon -o fbcomp fbcomp.c libvdmafb.c
+ */
+#define _GNU_SOURCE
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include "libvdmafb.h"
+#include "fbcomp.h"
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+#define COMP_MAX_CLIENTS    16
+#define COMP_MAX_DAMAGE     32      /*每帧屏幕损坏矩形数,超出后合并*/
+#define COMP_MAX_FDS        4       /*一个报文最多接收的fd数,只用第一个,其余关闭*/
+
+struct comp_client;
+
+struct comp_surface {
+    uint32_t id;
+    struct comp_client *owner;
+    int x, y, w, h, z;
+    unsigned int flags;
+    const uint8_t *pixels;          /*客户端共享内存,客户端随时可能在写*/
+    size_t size;
+    uint8_t *shadow;                /*合成器自己的副本,COMMIT时复制损坏区域,合成只读它*/
+    struct vdmafb_rect pending;     /*已DAMAGE未COMMIT的区域(surface坐标)*/
+    int has_pending;
+    int committed;                  /*本帧需要回复DONE*/
+    struct comp_surface *next;      /*按z从小到大排列*/
+};
+
+struct comp_client {
+    int fd;
+    int broken;                     /*报文发送失败,等待主循环断开*/
+};
+
+/*屏幕像素格式,只支持8位通道且按字节对齐的24/32位色*/
+struct comp_format {
+    unsigned int bpp;
+    unsigned int ri, gi, bi;        /*R,G,B在像素中的字节位置*/
+};
+
+struct comp {
+    struct vdmafb *fb;
+    const struct vdmafb_info *info;
+    struct comp_format fmt;
+    uint8_t bg[4];                  /*背景色,按屏幕格式排列的一个像素*/
+
+    int listen_fd;
+    struct comp_client clients[COMP_MAX_CLIENTS];
+    struct comp_surface *surfaces;
+    uint32_t next_id;
+
+    struct vdmafb_rect damage[COMP_MAX_DAMAGE];
+    unsigned int ndamage;
+    uint64_t frame;
+};
+
+static volatile int comp_quit;
+
+static void comp_sigterm(int sig)
+{
+    (void)sig;
+    comp_quit = 1;
+}
+
+/*---------------------------------- 矩形 ----------------------------------*/
+
+static int rect_intersect(const struct vdmafb_rect *a, const struct vdmafb_rect *b,
+                          struct vdmafb_rect *out)
+{
+    int x0 = a->x > b->x ? a->x : b->x;
+    int y0 = a->y > b->y ? a->y : b->y;
+    int x1 = a->x + a->w < b->x + b->w ? a->x + a->w : b->x + b->w;
+    int y1 = a->y + a->h < b->y + b->h ? a->y + a->h : b->y + b->h;
+
+    if (x1 <= x0 || y1 <= y0)
+        return 0;
+    out->x = x0;
+    out->y = y0;
+    out->w = x1 - x0;
+    out->h = y1 - y0;
+    return 1;
+}
+
+static int rect_contains(const struct vdmafb_rect *outer, const struct vdmafb_rect *inner)
+{
+    return inner->x >= outer->x && inner->y >= outer->y &&
+           inner->x + inner->w <= outer->x + outer->w &&
+           inner->y + inner->h <= outer->y + outer->h;
+}
+
+static void rect_union(struct vdmafb_rect *a, const struct vdmafb_rect *b)
+{
+    int x0 = a->x < b->x ? a->x : b->x;
+    int y0 = a->y < b->y ? a->y : b->y;
+    int x1 = a->x + a->w > b->x + b->w ? a->x + a->w : b->x + b->w;
+    int y1 = a->y + a->h > b->y + b->h ? a->y + a->h : b->y + b->h;
+
+    a->x = x0;
+    a->y = y0;
+    a->w = x1 - x0;
+    a->h = y1 - y0;
+}
+
+/*记录屏幕损坏区域;与已有矩形相交时合并,避免重复合成重叠部分*/
+static void comp_add_damage(struct comp *c, const struct vdmafb_rect *r)
+{
+    struct vdmafb_rect screen = { 0, 0, (int)c->info->width, (int)c->info->height };
+    struct vdmafb_rect d, tmp;
+    unsigned int i;
+
+    if (!rect_intersect(r, &screen, &d))
+        return;
+    for (i = 0; i < c->ndamage; i++) {
+        if (rect_intersect(&c->damage[i], &d, &tmp)) {
+            rect_union(&d, &c->damage[i]);
+            c->damage[i] = c->damage[--c->ndamage];
+            i = -1;     /*合并后可能与其它矩形相交,重新检查*/
+        }
+    }
+    if (c->ndamage == COMP_MAX_DAMAGE) {
+        for (i = 1; i < c->ndamage; i++)
+            rect_union(&c->damage[0], &c->damage[i]);
+        c->ndamage = 1;
+        rect_union(&c->damage[0], &d);
+        return;
+    }
+    c->damage[c->ndamage++] = d;
+}
+
+static void comp_damage_surface(struct comp *c, const struct comp_surface *s)
+{
+    struct vdmafb_rect r = { s->x, s->y, s->w, s->h };
+
+    if (!(s->flags & FBCOMP_SURF_HIDDEN))
+        comp_add_damage(c, &r);
+}
+
+/*---------------------------------- 像素 ----------------------------------*/
+
+/*a*b/255,四舍五入*/
+static inline uint8_t mul255(unsigned int a, unsigned int b)
+{
+    unsigned int t = a * b + 128;
+
+    return (t + (t >> 8)) >> 8;
+}
+
+#ifdef __ARM_NEON
+static inline uint8x16_t neon_mul255(uint8x16_t a, uint8x16_t b)
+{
+    uint16x8_t lo = vmull_u8(vget_low_u8(a), vget_low_u8(b));
+    uint16x8_t hi = vmull_u8(vget_high_u8(a), vget_high_u8(b));
+
+    return vcombine_u8(vrshrn_n_u16(vrsraq_n_u16(lo, lo, 8), 8),
+                       vrshrn_n_u16(vrsraq_n_u16(hi, hi, 8), 8));
+}
+#endif
+
+/*预乘alpha混合: dst = src + dst * (255 - a) / 255*/
+static void comp_blend_row(const struct comp_format *f, uint8_t *dst, const uint8_t *src, int n)
+{
+    int i = 0;
+
+#ifdef __ARM_NEON
+    if (f->bpp == 3) {
+        for (; i + 16 <= n; i += 16) {
+            uint8x16x4_t s = vld4q_u8(src + i * 4);
+            uint8x16x3_t d = vld3q_u8(dst + i * 3);
+            uint8x16_t ia = vmvnq_u8(s.val[3]);
+
+            d.val[f->ri] = vqaddq_u8(s.val[0], neon_mul255(d.val[f->ri], ia));
+            d.val[f->gi] = vqaddq_u8(s.val[1], neon_mul255(d.val[f->gi], ia));
+            d.val[f->bi] = vqaddq_u8(s.val[2], neon_mul255(d.val[f->bi], ia));
+            vst3q_u8(dst + i * 3, d);
+        }
+    } else {
+        for (; i + 16 <= n; i += 16) {
+            uint8x16x4_t s = vld4q_u8(src + i * 4);
+            uint8x16x4_t d = vld4q_u8(dst + i * 4);
+            uint8x16_t ia = vmvnq_u8(s.val[3]);
+
+            d.val[f->ri] = vqaddq_u8(s.val[0], neon_mul255(d.val[f->ri], ia));
+            d.val[f->gi] = vqaddq_u8(s.val[1], neon_mul255(d.val[f->gi], ia));
+            d.val[f->bi] = vqaddq_u8(s.val[2], neon_mul255(d.val[f->bi], ia));
+            vst4q_u8(dst + i * 4, d);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        const uint8_t *s = src + i * 4;
+        uint8_t *d = dst + i * f->bpp;
+        unsigned int ia = 255 - s[3];
+        unsigned int v;
+
+        v = s[0] + mul255(d[f->ri], ia);
+        d[f->ri] = v > 255 ? 255 : v;
+        v = s[1] + mul255(d[f->gi], ia);
+        d[f->gi] = v > 255 ? 255 : v;
+        v = s[2] + mul255(d[f->bi], ia);
+        d[f->bi] = v > 255 ? 255 : v;
+    }
+}
+
+/*不透明surface:只做通道重排*/
+static void comp_copy_row(const struct comp_format *f, uint8_t *dst, const uint8_t *src, int n)
+{
+    int i = 0;
+
+#ifdef __ARM_NEON
+    if (f->bpp == 3) {
+        for (; i + 16 <= n; i += 16) {
+            uint8x16x4_t s = vld4q_u8(src + i * 4);
+            uint8x16x3_t d;
+
+            d.val[f->ri] = s.val[0];
+            d.val[f->gi] = s.val[1];
+            d.val[f->bi] = s.val[2];
+            vst3q_u8(dst + i * 3, d);
+        }
+    } else {
+        for (; i + 16 <= n; i += 16) {
+            uint8x16x4_t s = vld4q_u8(src + i * 4);
+            uint8x16x4_t d;
+
+            d.val[0] = d.val[1] = d.val[2] = d.val[3] = vdupq_n_u8(0xff);
+            d.val[f->ri] = s.val[0];
+            d.val[f->gi] = s.val[1];
+            d.val[f->bi] = s.val[2];
+            vst4q_u8(dst + i * 4, d);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        const uint8_t *s = src + i * 4;
+        uint8_t *d = dst + i * f->bpp;
+
+        if (f->bpp == 4)
+            d[0] = d[1] = d[2] = d[3] = 0xff;
+        d[f->ri] = s[0];
+        d[f->gi] = s[1];
+        d[f->bi] = s[2];
+    }
+}
+
+static void comp_fill_row(const struct comp *c, uint8_t *dst, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++, dst += c->fmt.bpp)
+        memcpy(dst, c->bg, c->fmt.bpp);
+}
+
+/*在buf中重新合成屏幕区域r*/
+static void comp_compose_rect(struct comp *c, uint8_t *buf, const struct vdmafb_rect *r)
+{
+    unsigned int stride = c->info->stride;
+    unsigned int bpp = c->fmt.bpp;
+    struct comp_surface *s, *base = NULL;
+    struct vdmafb_rect sr, in;
+    int y;
+
+    /*完全覆盖该区域的最上层不透明surface以下的内容都不可见*/
+    for (s = c->surfaces; s; s = s->next) {
+        sr.x = s->x;
+        sr.y = s->y;
+        sr.w = s->w;
+        sr.h = s->h;
+        if (!(s->flags & FBCOMP_SURF_HIDDEN) && (s->flags & FBCOMP_SURF_OPAQUE) &&
+            rect_contains(&sr, r))
+            base = s;
+    }
+    if (!base) {
+        for (y = 0; y < r->h; y++)
+            comp_fill_row(c, buf + (size_t)(r->y + y) * stride + (size_t)r->x * bpp, r->w);
+        s = c->surfaces;
+    } else {
+        s = base;
+    }
+
+    for (; s; s = s->next) {
+        if (s->flags & FBCOMP_SURF_HIDDEN)
+            continue;
+        sr.x = s->x;
+        sr.y = s->y;
+        sr.w = s->w;
+        sr.h = s->h;
+        if (!rect_intersect(&sr, r, &in))
+            continue;
+        for (y = 0; y < in.h; y++) {
+            uint8_t *d = buf + (size_t)(in.y + y) * stride + (size_t)in.x * bpp;
+            const uint8_t *p = s->shadow + (size_t)(in.y - s->y + y) * s->w * 4 +
+                               (size_t)(in.x - s->x) * 4;
+
+            if (s->flags & FBCOMP_SURF_OPAQUE)
+                comp_copy_row(&c->fmt, d, p, in.w);
+            else
+                comp_blend_row(&c->fmt, d, p, in.w);
+        }
+    }
+}
+
+/*
+ * 合成器不能阻塞在某个客户端上,发送失败(包括发送缓冲区满)时不能丢掉报文,
+ * 否则客户端会永远等不到DONE,只能标记后由主循环断开该客户端
+ */
+static void comp_send(struct comp_client *cl, const struct fbcomp_msg *msg)
+{
+    if (cl->broken)
+        return;
+    if (send(cl->fd, msg, sizeof(*msg), MSG_NOSIGNAL | MSG_DONTWAIT) != sizeof(*msg))
+        cl->broken = 1;
+}
+
+static void comp_frame(struct comp *c)
+{
+    struct comp_surface *s;
+    uint8_t *buf;
+    unsigned int i;
+
+    buf = vdmafb_begin(c->fb);
+    for (i = 0; i < c->ndamage; i++) {
+        comp_compose_rect(c, buf, &c->damage[i]);
+        vdmafb_damage(c->fb, &c->damage[i]);
+    }
+    c->ndamage = 0;
+    vdmafb_present(c->fb);
+    c->frame++;
+
+    /*提交的内容已在副本中并已显示,通知客户端*/
+    for (s = c->surfaces; s; s = s->next) {
+        if (s->committed) {
+            struct fbcomp_msg msg = { .type = FBCOMP_DONE, .id = s->id, .seq = c->frame };
+
+            s->committed = 0;
+            comp_send(s->owner, &msg);
+        }
+    }
+}
+
+/*---------------------------------- surface ----------------------------------*/
+
+static void comp_insert(struct comp *c, struct comp_surface *surf)
+{
+    struct comp_surface **pp = &c->surfaces;
+
+    while (*pp && (*pp)->z <= surf->z)
+        pp = &(*pp)->next;
+    surf->next = *pp;
+    *pp = surf;
+}
+
+static void comp_unlink(struct comp *c, struct comp_surface *surf)
+{
+    struct comp_surface **pp;
+
+    for (pp = &c->surfaces; *pp; pp = &(*pp)->next) {
+        if (*pp == surf) {
+            *pp = surf->next;
+            return;
+        }
+    }
+}
+
+static struct comp_surface *comp_find(struct comp *c, struct comp_client *cl, uint32_t id)
+{
+    struct comp_surface *s;
+
+    for (s = c->surfaces; s; s = s->next)
+        if (s->id == id && s->owner == cl)
+            return s;
+    return NULL;
+}
+
+/*把surface坐标中的区域r从客户端共享内存复制到副本*/
+static void comp_snapshot(struct comp_surface *s, const struct vdmafb_rect *r)
+{
+    size_t stride = (size_t)s->w * 4;
+    size_t off = (size_t)r->y * stride + (size_t)r->x * 4;
+    int y;
+
+    for (y = 0; y < r->h; y++, off += stride)
+        memcpy(s->shadow + off, s->pixels + off, (size_t)r->w * 4);
+}
+
+static void comp_destroy_surface(struct comp *c, struct comp_surface *s)
+{
+    comp_damage_surface(c, s);
+    comp_unlink(c, s);
+    munmap((void *)s->pixels, s->size);
+    free(s->shadow);
+    free(s);
+}
+
+static uint32_t comp_create_surface(struct comp *c, struct comp_client *cl,
+                                    const struct fbcomp_msg *msg, int fd)
+{
+    const int seals = F_SEAL_SHRINK | F_SEAL_GROW;
+    struct comp_surface *s;
+    struct stat st;
+    size_t size;
+    int have;
+
+    if (fd < 0 || msg->w <= 0 || msg->h <= 0 || msg->w > 8192 || msg->h > 8192)
+        return 0;
+    /*文件必须足够大且不能再改变大小,否则合成时访问映射可能收到SIGBUS*/
+    size = (size_t)msg->w * msg->h * 4;
+    if (fstat(fd, &st) || (size_t)st.st_size < size)
+        return 0;
+    have = fcntl(fd, F_GET_SEALS);
+    if (have < 0 || (have & seals) != seals)
+        return 0;
+    s = calloc(1, sizeof(*s));
+    if (!s)
+        return 0;
+    s->size = size;
+    /*第一次COMMIT之前没有可显示的内容,副本清零即全透明*/
+    s->shadow = calloc(1, size);
+    if (!s->shadow) {
+        free(s);
+        return 0;
+    }
+    s->pixels = mmap(NULL, s->size, PROT_READ, MAP_SHARED, fd, 0);
+    if (s->pixels == MAP_FAILED) {
+        free(s->shadow);
+        free(s);
+        return 0;
+    }
+    s->id = ++c->next_id ? c->next_id : ++c->next_id;
+    s->owner = cl;
+    s->x = msg->x;
+    s->y = msg->y;
+    s->w = msg->w;
+    s->h = msg->h;
+    s->z = msg->z;
+    s->flags = msg->flags;
+    comp_insert(c, s);
+    comp_damage_surface(c, s);
+    return s->id;
+}
+
+static void comp_client_close(struct comp *c, struct comp_client *cl)
+{
+    struct comp_surface *s, *next;
+
+    for (s = c->surfaces; s; s = next) {
+        next = s->next;
+        if (s->owner == cl)
+            comp_destroy_surface(c, s);
+    }
+    close(cl->fd);
+    cl->fd = -1;
+    cl->broken = 0;
+}
+
+/*处理一个报文,返回0表示暂无报文,-1表示客户端已断开*/
+static int comp_client_msg(struct comp *c, struct comp_client *cl)
+{
+    char cbuf[CMSG_SPACE(sizeof(int) * COMP_MAX_FDS)];
+    struct fbcomp_msg msg, reply;
+    struct iovec iov = { &msg, sizeof(msg) };
+    struct msghdr mh;
+    struct cmsghdr *cm;
+    struct comp_surface *s;
+    struct vdmafb_rect r, sr;
+    int fd = -1;
+    ssize_t n;
+    int *fds;
+    size_t i, nfds;
+
+    if (cl->broken)
+        return 0;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = cbuf;
+    mh.msg_controllen = sizeof(cbuf);
+    n = recvmsg(cl->fd, &mh, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+    if (n != sizeof(msg)) {
+        comp_client_close(c, cl);
+        return -1;
+    }
+    /*
+     * 收到的每个fd都已装入本进程,只保留第一个,其余立即关闭,
+     * 否则客户端可以用多余的fd耗尽合成器的fd表
+     */
+    for (cm = CMSG_FIRSTHDR(&mh); cm; cm = CMSG_NXTHDR(&mh, cm)) {
+        if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS)
+            continue;
+        fds = (int *)CMSG_DATA(cm);
+        nfds = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (i = 0; i < nfds; i++) {
+            int f;
+
+            memcpy(&f, &fds[i], sizeof(int));
+            if (fd < 0)
+                fd = f;
+            else
+                close(f);
+        }
+    }
+    /*控制信息被截断说明客户端不守协议,丢弃该报文;CREATE回复失败*/
+    if (mh.msg_flags & MSG_CTRUNC) {
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+        if (msg.type != FBCOMP_CREATE)
+            return 1;
+    }
+
+    switch (msg.type) {
+    case FBCOMP_CREATE:
+        memset(&reply, 0, sizeof(reply));
+        reply.type = FBCOMP_CREATED;
+        reply.id = comp_create_surface(c, cl, &msg, fd);
+        comp_send(cl, &reply);
+        break;
+    case FBCOMP_DESTROY:
+        s = comp_find(c, cl, msg.id);
+        if (s)
+            comp_destroy_surface(c, s);
+        break;
+    case FBCOMP_MOVE:
+        s = comp_find(c, cl, msg.id);
+        if (!s)
+            break;
+        comp_damage_surface(c, s);
+        comp_unlink(c, s);
+        s->x = msg.x;
+        s->y = msg.y;
+        s->z = msg.z;
+        s->flags = msg.flags;
+        comp_insert(c, s);
+        comp_damage_surface(c, s);
+        break;
+    case FBCOMP_DAMAGE:
+        s = comp_find(c, cl, msg.id);
+        if (!s)
+            break;
+        sr.x = 0;
+        sr.y = 0;
+        sr.w = s->w;
+        sr.h = s->h;
+        r.x = msg.x;
+        r.y = msg.y;
+        r.w = msg.w;
+        r.h = msg.h;
+        if (rect_intersect(&r, &sr, &r)) {
+            if (s->has_pending)
+                rect_union(&s->pending, &r);
+            else
+                s->pending = r;
+            s->has_pending = 1;
+        }
+        break;
+    case FBCOMP_COMMIT:
+        /*
+         * 提交的损坏区域复制到副本后才参与合成,其它surface的提交或MOVE引起的
+         * 重新合成也只读副本,客户端画到一半的内容不会被显示
+         */
+        s = comp_find(c, cl, msg.id);
+        if (!s)
+            break;
+        if (s->has_pending) {
+            comp_snapshot(s, &s->pending);
+            /*隐藏的surface也更新副本,显示出来时才是最新内容*/
+            r = s->pending;
+            r.x += s->x;
+            r.y += s->y;
+            if (!(s->flags & FBCOMP_SURF_HIDDEN))
+                comp_add_damage(c, &r);
+        }
+        s->has_pending = 0;
+        s->committed = 1;
+        break;
+    }
+    /*fd已被mmap引用,或者不需要*/
+    if (fd >= 0)
+        close(fd);
+    return 1;
+}
+
+static int comp_listen(const char *path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) || listen(fd, 8)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int comp_init_format(struct comp *c)
+{
+    const struct vdmafb_info *info = c->info;
+
+    if ((info->bytes_pp != 3 && info->bytes_pp != 4) ||
+        info->red_length != 8 || info->green_length != 8 || info->blue_length != 8 ||
+        info->red_offset % 8 || info->green_offset % 8 || info->blue_offset % 8)
+        return -1;
+    c->fmt.bpp = info->bytes_pp;
+    c->fmt.ri = info->red_offset / 8;
+    c->fmt.gi = info->green_offset / 8;
+    c->fmt.bi = info->blue_offset / 8;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *dev = "/dev/fb0";
+    const char *path = FBCOMP_DEFAULT_SOCKET;
+    struct pollfd pfd[COMP_MAX_CLIENTS + 1];
+    struct comp_client *map[COMP_MAX_CLIENTS + 1];
+    unsigned int bg = 0;
+    struct comp c;
+    unsigned int i, n;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:s:b:")) != -1) {
+        switch (opt) {
+        case 'd':
+            dev = optarg;
+            break;
+        case 's':
+            path = optarg;
+            break;
+        case 'b':
+            bg = strtoul(optarg, NULL, 16);
+            break;
+        default:
+            printf("Usage: %s [-d /dev/fbN] [-s socket] [-b RRGGBB]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    memset(&c, 0, sizeof(c));
+    c.fb = vdmafb_open(dev, 0);
+    if (!c.fb) {
+        printf("Error: cannot open framebuffer device %s.\n", dev);
+        return 1;
+    }
+    c.info = vdmafb_get_info(c.fb);
+    if (comp_init_format(&c)) {
+        printf("Error: unsupported framebuffer format (%u bpp)\n", c.info->bits_pp);
+        return 1;
+    }
+    memset(c.bg, 0xff, sizeof(c.bg));
+    c.bg[c.fmt.ri] = bg >> 16;
+    c.bg[c.fmt.gi] = bg >> 8;
+    c.bg[c.fmt.bi] = bg;
+    for (i = 0; i < COMP_MAX_CLIENTS; i++)
+        c.clients[i].fd = -1;
+
+    c.listen_fd = comp_listen(path);
+    if (c.listen_fd < 0) {
+        printf("Error: cannot listen on %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    signal(SIGINT, comp_sigterm);
+    signal(SIGTERM, comp_sigterm);
+
+    /*启动时整屏画一次背景*/
+    {
+        struct vdmafb_rect all = { 0, 0, (int)c.info->width, (int)c.info->height };
+
+        comp_add_damage(&c, &all);
+    }
+
+    while (!comp_quit) {
+        n = 0;
+        pfd[n].fd = c.listen_fd;
+        pfd[n].events = POLLIN;
+        map[n++] = NULL;
+        for (i = 0; i < COMP_MAX_CLIENTS; i++) {
+            if (c.clients[i].fd < 0)
+                continue;
+            pfd[n].fd = c.clients[i].fd;
+            pfd[n].events = POLLIN;
+            map[n++] = &c.clients[i];
+        }
+
+        /*有待合成的区域时不阻塞,合成本身在vblank处等待*/
+        if (poll(pfd, n, c.ndamage ? 0 : -1) < 0 && errno != EINTR)
+            break;
+
+        if (pfd[0].revents & POLLIN) {
+            int fd = accept4(c.listen_fd, NULL, NULL, SOCK_CLOEXEC);
+
+            for (i = 0; fd >= 0 && i < COMP_MAX_CLIENTS; i++) {
+                if (c.clients[i].fd < 0) {
+                    c.clients[i].fd = fd;
+                    break;
+                }
+            }
+            if (fd >= 0 && i == COMP_MAX_CLIENTS)
+                close(fd);
+        }
+        for (i = 1; i < n; i++) {
+            /*一次取完该客户端的所有报文,同一帧的多个提交合并合成*/
+            if (pfd[i].revents & (POLLIN | POLLHUP | POLLERR))
+                while (comp_client_msg(&c, map[i]) > 0)
+                    ;
+        }
+
+        if (c.ndamage) {
+            comp_frame(&c);
+        } else {
+            /*没有可见变化的提交也要回复DONE*/
+            struct comp_surface *s;
+
+            for (s = c.surfaces; s; s = s->next) {
+                if (s->committed) {
+                    struct fbcomp_msg msg = { .type = FBCOMP_DONE, .id = s->id, .seq = c.frame };
+
+                    s->committed = 0;
+                    comp_send(s->owner, &msg);
+                }
+            }
+        }
+
+        for (i = 0; i < COMP_MAX_CLIENTS; i++)
+            if (c.clients[i].fd >= 0 && c.clients[i].broken)
+                comp_client_close(&c, &c.clients[i]);
+    }
+
+    for (i = 0; i < COMP_MAX_CLIENTS; i++)
+        if (c.clients[i].fd >= 0)
+            comp_client_close(&c, &c.clients[i]);
+    close(c.listen_fd);
+    unlink(path);
+    vdmafb_close(c.fb);
+    return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * fbcomp: 基于framebuffer的多客户端合成器
+ *
+ * 各进程在共享内存surface中绘制,提交损坏区域后由合成器(fbcomp守护进程)
+ * 只把这些区域按z序混合到后台缓冲区,再在vblank翻页.
+ * 多个应用同屏时CPU开销只与变化的像素数成正比.
+ *
+ * surface像素格式: 每像素4字节,内存中依次为R,G,B,A,颜色已预乘alpha.
+ * 行跨度为宽度*4.
+ *
+ * 合成器在处理COMMIT时把提交的损坏区域复制到自己的副本,合成只读副本,
+ * 没有提交的内容不会被显示.
+ * 客户端约定: fbcomp_surface_commit之后,在fbcomp_surface_wait返回(合成器已
+ * 复制完该次提交)之前不要再写surface,否则副本中可能是画到一半的内容.
+ *
+ * 协议: AF_UNIX SOCK_SEQPACKET,每个报文为一个struct fbcomp_msg,
+ * FBCOMP_CREATE随报文用SCM_RIGHTS传递surface的共享内存fd.该fd必须是memfd,
+ * 大小不小于w*h*4,并已加上F_SEAL_SHRINK|F_SEAL_GROW封印,否则创建失败
+ * (防止客户端在合成器读取时截断文件使其收到SIGBUS).
+ * 客户端必须及时读取合成器的报文,发送缓冲区满时合成器会断开该客户端.
+ */
+#ifndef __FBCOMP_H
+#define __FBCOMP_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FBCOMP_DEFAULT_SOCKET   "/tmp/fbcomp.sock"
+
+/*客户端->合成器*/
+#define FBCOMP_CREATE       1   /*x,y,w,h,z,flags;附带fd*/
+#define FBCOMP_DESTROY      2   /*id*/
+#define FBCOMP_MOVE         3   /*id,x,y,z,flags*/
+#define FBCOMP_DAMAGE       4   /*id,x,y,w,h(surface坐标)*/
+#define FBCOMP_COMMIT       5   /*id,之前的DAMAGE在下一帧生效*/
+
+/*合成器->客户端*/
+#define FBCOMP_CREATED      16  /*id;id为0表示失败*/
+#define FBCOMP_DONE         17  /*id,seq为显示该次提交的帧号*/
+
+/*surface标志*/
+#define FBCOMP_SURF_OPAQUE  (1u << 0)   /*不透明,直接拷贝不做混合*/
+#define FBCOMP_SURF_HIDDEN  (1u << 1)   /*不参与合成*/
+
+struct fbcomp_msg {
+    uint32_t type;
+    uint32_t id;
+    int32_t x, y;
+    int32_t w, h;
+    int32_t z;              /*越大越靠上*/
+    uint32_t flags;
+    uint64_t seq;
+};
+
+struct fbcomp_rect {
+    int x, y;
+    int w, h;
+};
+
+/*---------------------------- 客户端接口(fbcomp_client.c) ----------------------------*/
+
+struct fbcomp;
+
+struct fbcomp_surface {
+    struct fbcomp *conn;
+    uint32_t id;
+    int w, h;
+    unsigned int stride;
+    uint8_t *pixels;        /*R,G,B,A预乘*/
+    int busy;               /*已提交,等待合成器完成*/
+    uint64_t last_seq;
+    struct fbcomp_surface *next;
+};
+
+struct fbcomp *fbcomp_connect(const char *path);
+void fbcomp_disconnect(struct fbcomp *conn);
+int fbcomp_fd(const struct fbcomp *conn);
+/*处理已到达的事件,不阻塞;可在自己的poll循环中调用*/
+int fbcomp_dispatch(struct fbcomp *conn);
+
+struct fbcomp_surface *fbcomp_surface_create(struct fbcomp *conn, int x, int y, int w, int h,
+                                             int z, unsigned int flags);
+void fbcomp_surface_destroy(struct fbcomp_surface *surf);
+int fbcomp_surface_move(struct fbcomp_surface *surf, int x, int y, int z, unsigned int flags);
+int fbcomp_surface_damage(struct fbcomp_surface *surf, const struct fbcomp_rect *rect);
+int fbcomp_surface_commit(struct fbcomp_surface *surf);
+/*等待上一次提交被合成,之后可以继续绘制*/
+int fbcomp_surface_wait(struct fbcomp_surface *surf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,239 @@
+/*
+ * fbcomp客户端库,接口说明见fbcomp.h
+ *
+ * 编译: $(CROSS_COMPILE)gcc -O2 -c fbcomp_client.c
+ */
+#define _GNU_SOURCE
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/memfd.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include "fbcomp.h"
+
+struct fbcomp {
+    int fd;
+    struct fbcomp_surface *surfaces;
+    uint32_t created_id;        /*最近一次FBCOMP_CREATED的结果*/
+    int created;
+};
+
+struct fbcomp *fbcomp_connect(const char *path)
+{
+    struct sockaddr_un addr;
+    struct fbcomp *conn;
+
+    conn = calloc(1, sizeof(*conn));
+    if (!conn)
+        return NULL;
+    conn->fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (conn->fd < 0)
+        goto err_free;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path ? path : FBCOMP_DEFAULT_SOCKET, sizeof(addr.sun_path) - 1);
+    if (connect(conn->fd, (struct sockaddr *)&addr, sizeof(addr)))
+        goto err_close;
+    return conn;
+
+err_close:
+    close(conn->fd);
+err_free:
+    free(conn);
+    return NULL;
+}
+
+void fbcomp_disconnect(struct fbcomp *conn)
+{
+    if (!conn)
+        return;
+    while (conn->surfaces)
+        fbcomp_surface_destroy(conn->surfaces);
+    close(conn->fd);
+    free(conn);
+}
+
+int fbcomp_fd(const struct fbcomp *conn)
+{
+    return conn->fd;
+}
+
+static int fbcomp_send(struct fbcomp *conn, const struct fbcomp_msg *msg, int fd)
+{
+    char cbuf[CMSG_SPACE(sizeof(int))];
+    struct iovec iov = { (void *)msg, sizeof(*msg) };
+    struct msghdr mh;
+
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    if (fd >= 0) {
+        struct cmsghdr *cm;
+
+        memset(cbuf, 0, sizeof(cbuf));
+        mh.msg_control = cbuf;
+        mh.msg_controllen = sizeof(cbuf);
+        cm = CMSG_FIRSTHDR(&mh);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cm), &fd, sizeof(int));
+    }
+    return sendmsg(conn->fd, &mh, MSG_NOSIGNAL) == sizeof(*msg) ? 0 : -1;
+}
+
+static void fbcomp_handle(struct fbcomp *conn, const struct fbcomp_msg *msg)
+{
+    struct fbcomp_surface *s;
+
+    switch (msg->type) {
+    case FBCOMP_CREATED:
+        conn->created_id = msg->id;
+        conn->created = 1;
+        break;
+    case FBCOMP_DONE:
+        for (s = conn->surfaces; s; s = s->next) {
+            if (s->id == msg->id) {
+                s->busy = 0;
+                s->last_seq = msg->seq;
+            }
+        }
+        break;
+    }
+}
+
+/*读取一个事件;block为0时没有事件返回0*/
+static int fbcomp_read_one(struct fbcomp *conn, int block)
+{
+    struct fbcomp_msg msg;
+    ssize_t n;
+
+    n = recv(conn->fd, &msg, sizeof(msg), block ? 0 : MSG_DONTWAIT);
+    if (n < 0)
+        return (!block && (errno == EAGAIN || errno == EWOULDBLOCK)) ? 0 : -1;
+    if (n != sizeof(msg))
+        return -1;      /*n为0表示合成器已退出*/
+    fbcomp_handle(conn, &msg);
+    return 1;
+}
+
+int fbcomp_dispatch(struct fbcomp *conn)
+{
+    int ret;
+
+    while ((ret = fbcomp_read_one(conn, 0)) > 0)
+        ;
+    return ret;
+}
+
+struct fbcomp_surface *fbcomp_surface_create(struct fbcomp *conn, int x, int y, int w, int h,
+                                             int z, unsigned int flags)
+{
+    struct fbcomp_msg msg = { .type = FBCOMP_CREATE, .x = x, .y = y, .w = w, .h = h,
+                              .z = z, .flags = flags };
+    struct fbcomp_surface *surf;
+    size_t size;
+    int fd;
+
+    if (w <= 0 || h <= 0)
+        return NULL;
+    surf = calloc(1, sizeof(*surf));
+    if (!surf)
+        return NULL;
+    surf->conn = conn;
+    surf->w = w;
+    surf->h = h;
+    surf->stride = w * 4;
+    size = (size_t)surf->stride * h;
+
+    /*合成器要求封印大小,保证它映射的内存不会被截断*/
+    fd = syscall(__NR_memfd_create, "fbcomp-surface", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0 || ftruncate(fd, size) ||
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW))
+        goto err;
+    surf->pixels = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (surf->pixels == MAP_FAILED)
+        goto err;
+
+    conn->created = 0;
+    if (fbcomp_send(conn, &msg, fd))
+        goto err_unmap;
+    while (!conn->created) {
+        if (fbcomp_read_one(conn, 1) < 0)
+            goto err_unmap;
+    }
+    if (!conn->created_id)
+        goto err_unmap;
+    close(fd);
+
+    surf->id = conn->created_id;
+    surf->next = conn->surfaces;
+    conn->surfaces = surf;
+    return surf;
+
+err_unmap:
+    munmap(surf->pixels, size);
+err:
+    if (fd >= 0)
+        close(fd);
+    free(surf);
+    return NULL;
+}
+
+void fbcomp_surface_destroy(struct fbcomp_surface *surf)
+{
+    struct fbcomp *conn = surf->conn;
+    struct fbcomp_msg msg = { .type = FBCOMP_DESTROY, .id = surf->id };
+    struct fbcomp_surface **pp;
+
+    fbcomp_send(conn, &msg, -1);
+    for (pp = &conn->surfaces; *pp; pp = &(*pp)->next) {
+        if (*pp == surf) {
+            *pp = surf->next;
+            break;
+        }
+    }
+    munmap(surf->pixels, (size_t)surf->stride * surf->h);
+    free(surf);
+}
+
+int fbcomp_surface_move(struct fbcomp_surface *surf, int x, int y, int z, unsigned int flags)
+{
+    struct fbcomp_msg msg = { .type = FBCOMP_MOVE, .id = surf->id, .x = x, .y = y,
+                              .z = z, .flags = flags };
+
+    return fbcomp_send(surf->conn, &msg, -1);
+}
+
+int fbcomp_surface_damage(struct fbcomp_surface *surf, const struct fbcomp_rect *rect)
+{
+    struct fbcomp_msg msg = { .type = FBCOMP_DAMAGE, .id = surf->id, .x = rect->x,
+                              .y = rect->y, .w = rect->w, .h = rect->h };
+
+    return fbcomp_send(surf->conn, &msg, -1);
+}
+
+int fbcomp_surface_commit(struct fbcomp_surface *surf)
+{
+    struct fbcomp_msg msg = { .type = FBCOMP_COMMIT, .id = surf->id };
+
+    surf->busy = 1;
+    return fbcomp_send(surf->conn, &msg, -1);
+}
+
+int fbcomp_surface_wait(struct fbcomp_surface *surf)
+{
+    while (surf->busy) {
+        if (fbcomp_read_one(surf->conn, 1) < 0)
+            return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,453 @@
+/*
+ * libvdmafb: framebuffer用户空间辅助库,接口说明见libvdmafb.h
+ */
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <linux/fb.h>
+#include "xlnx_vdmafb.h"
+#include "libvdmafb.h"
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+#ifndef FBIO_WAITFORVSYNC
+#define FBIO_WAITFORVSYNC _IOW('F', 0x20, __u32)
+#endif
+
+#define VDMAFB_LIB_MAX_BUFFERS  4
+
+/*一帧的损坏区域*/
+struct vdmafb_damage_list {
+    struct vdmafb_rect rects[VDMAFB_MAX_DAMAGE];
+    unsigned int count;
+};
+
+struct vdmafb {
+    int fd;
+    unsigned int flags;
+    struct vdmafb_info info;
+    struct fb_var_screeninfo var;
+    unsigned char *base;
+    size_t map_size;
+
+    unsigned int front;             /*当前显示的缓冲区*/
+    unsigned int back;              /*vdmafb_begin返回的缓冲区*/
+    /*
+     * 最近几帧的损坏区域,history[i]为向前第i+1帧.
+     * 轮换到的后台缓冲区缺少最近num_buffers-1帧的改动,开始一帧时从前台补齐
+     */
+    struct vdmafb_damage_list history[VDMAFB_LIB_MAX_BUFFERS - 1];
+    struct vdmafb_damage_list cur;  /*本帧*/
+    struct timespec next_vblank;    /*无vsync时的定时节拍*/
+};
+
+static int vdmafb_rect_clip(const struct vdmafb *fb, const struct vdmafb_rect *in,
+                            struct vdmafb_rect *out)
+{
+    int x0 = in->x < 0 ? 0 : in->x;
+    int y0 = in->y < 0 ? 0 : in->y;
+    int x1 = in->x + in->w;
+    int y1 = in->y + in->h;
+
+    if (x1 > (int)fb->info.width)
+        x1 = fb->info.width;
+    if (y1 > (int)fb->info.height)
+        y1 = fb->info.height;
+    if (x1 <= x0 || y1 <= y0)
+        return 0;
+    out->x = x0;
+    out->y = y0;
+    out->w = x1 - x0;
+    out->h = y1 - y0;
+    return 1;
+}
+
+static void vdmafb_rect_union(struct vdmafb_rect *a, const struct vdmafb_rect *b)
+{
+    int x0 = a->x < b->x ? a->x : b->x;
+    int y0 = a->y < b->y ? a->y : b->y;
+    int x1 = a->x + a->w > b->x + b->w ? a->x + a->w : b->x + b->w;
+    int y1 = a->y + a->h > b->y + b->h ? a->y + a->h : b->y + b->h;
+
+    a->x = x0;
+    a->y = y0;
+    a->w = x1 - x0;
+    a->h = y1 - y0;
+}
+
+static void vdmafb_damage_add(struct vdmafb_damage_list *list, const struct vdmafb_rect *r)
+{
+    unsigned int i;
+
+    /*列表满时全部合并为一个外接矩形*/
+    if (list->count == VDMAFB_MAX_DAMAGE) {
+        for (i = 1; i < list->count; i++)
+            vdmafb_rect_union(&list->rects[0], &list->rects[i]);
+        list->count = 1;
+    }
+    if (list->count == 1 && list->rects[0].x == r->x && list->rects[0].w == r->w &&
+        list->rects[0].y + list->rects[0].h == r->y) {
+        list->rects[0].h += r->h;   /*同宽且上下相接,常见的逐行更新*/
+        return;
+    }
+    list->rects[list->count++] = *r;
+}
+
+static void vdmafb_damage_full(const struct vdmafb *fb, struct vdmafb_damage_list *list)
+{
+    list->rects[0].x = 0;
+    list->rects[0].y = 0;
+    list->rects[0].w = fb->info.width;
+    list->rects[0].h = fb->info.height;
+    list->count = 1;
+}
+
+static unsigned char *vdmafb_buffer(const struct vdmafb *fb, unsigned int index)
+{
+    return fb->base + (size_t)index * fb->info.height * fb->info.stride;
+}
+
+/*通知驱动被改写的行,驱动据此只对这些行更新帧签名等*/
+static void vdmafb_flush_rect(struct vdmafb *fb, unsigned int index, const struct vdmafb_rect *r)
+{
+    struct vdmafb_damage d;
+
+    if (!fb->info.has_damage)
+        return;
+    d.y = index * fb->info.height + r->y;
+    d.height = r->h;
+    if (ioctl(fb->fd, VDMAFB_IOCTL_DAMAGE, &d))
+        fb->info.has_damage = 0;
+}
+
+static double vdmafb_probe_period(struct vdmafb *fb)
+{
+    struct fb_var_screeninfo *v = &fb->var;
+    struct vdmafb_vblank_info vbi;
+    double htotal, vtotal;
+
+    if (ioctl(fb->fd, VDMAFB_IOCTL_GET_VBLANK, &vbi) == 0 && vbi.period_ns)
+        return vbi.period_ns / 1e9;
+    htotal = v->xres + v->left_margin + v->right_margin + v->hsync_len;
+    vtotal = v->yres + v->upper_margin + v->lower_margin + v->vsync_len;
+    if (v->pixclock)
+        return htotal * vtotal * v->pixclock * 1e-12;
+    return 1.0 / 60;
+}
+
+struct vdmafb *vdmafb_open(const char *path, unsigned int flags)
+{
+    struct fb_fix_screeninfo fix;
+    struct vdmafb_damage d = { 0, 0 };
+    struct vdmafb *fb;
+    __u32 crtc = 0;
+    unsigned int i;
+
+    fb = calloc(1, sizeof(*fb));
+    if (!fb)
+        return NULL;
+    fb->flags = flags;
+
+    fb->fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fb->fd < 0)
+        goto err_free;
+    if (ioctl(fb->fd, FBIOGET_FSCREENINFO, &fix) || ioctl(fb->fd, FBIOGET_VSCREENINFO, &fb->var))
+        goto err_close;
+    if (fix.type != FB_TYPE_PACKED_PIXELS || fb->var.bits_per_pixel < 16)
+        goto err_close;
+
+    fb->info.width = fb->var.xres;
+    fb->info.height = fb->var.yres;
+    fb->info.stride = fix.line_length;
+    fb->info.bits_pp = fb->var.bits_per_pixel;
+    fb->info.bytes_pp = (fb->var.bits_per_pixel + 7) / 8;
+    fb->info.red_offset = fb->var.red.offset;
+    fb->info.red_length = fb->var.red.length;
+    fb->info.green_offset = fb->var.green.offset;
+    fb->info.green_length = fb->var.green.length;
+    fb->info.blue_offset = fb->var.blue.offset;
+    fb->info.blue_length = fb->var.blue.length;
+
+    /*只有整屏对齐的y方向pan才用于翻页*/
+    fb->info.num_buffers = fb->var.yres ? fb->var.yres_virtual / fb->var.yres : 1;
+    if (fb->info.num_buffers > VDMAFB_LIB_MAX_BUFFERS)
+        fb->info.num_buffers = VDMAFB_LIB_MAX_BUFFERS;
+    if (!fix.ypanstep || (flags & VDMAFB_F_SINGLE_BUFFER) || fb->info.num_buffers < 1)
+        fb->info.num_buffers = 1;
+
+    fb->info.has_vsync = ioctl(fb->fd, FBIO_WAITFORVSYNC, &crtc) == 0;
+    fb->info.has_damage = ioctl(fb->fd, VDMAFB_IOCTL_DAMAGE, &d) == 0;
+    fb->info.period = vdmafb_probe_period(fb);
+
+    fb->map_size = (size_t)fb->var.yres_virtual * fix.line_length;
+    fb->base = mmap(NULL, fb->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fb->fd, 0);
+    if (fb->base == MAP_FAILED)
+        goto err_close;
+
+    fb->front = fb->info.num_buffers > 1 ? fb->var.yoffset / fb->var.yres : 0;
+    if (fb->front >= fb->info.num_buffers)
+        fb->front = 0;
+    fb->back = fb->front;
+    /*其它缓冲区内容未知,第一次轮换到时整屏从前台复制*/
+    for (i = 0; i < VDMAFB_LIB_MAX_BUFFERS - 1; i++)
+        vdmafb_damage_full(fb, &fb->history[i]);
+    clock_gettime(CLOCK_MONOTONIC, &fb->next_vblank);
+    return fb;
+
+err_close:
+    close(fb->fd);
+err_free:
+    free(fb);
+    return NULL;
+}
+
+void vdmafb_close(struct vdmafb *fb)
+{
+    if (!fb)
+        return;
+    munmap(fb->base, fb->map_size);
+    close(fb->fd);
+    free(fb);
+}
+
+const struct vdmafb_info *vdmafb_get_info(const struct vdmafb *fb)
+{
+    return &fb->info;
+}
+
+static void vdmafb_copy_rect(struct vdmafb *fb, unsigned char *dst, const unsigned char *src,
+                             const struct vdmafb_rect *r)
+{
+    size_t off = (size_t)r->y * fb->info.stride + (size_t)r->x * fb->info.bytes_pp;
+
+    vdmafb_blit(fb, dst, r->x, r->y, src + off, fb->info.stride, r->w, r->h);
+}
+
+void *vdmafb_begin(struct vdmafb *fb)
+{
+    unsigned char *front, *back;
+    unsigned int i, j;
+
+    fb->cur.count = 0;
+    if (fb->info.num_buffers == 1) {
+        fb->back = fb->front;
+        return vdmafb_buffer(fb, fb->front);
+    }
+
+    fb->back = (fb->front + 1) % fb->info.num_buffers;
+    front = vdmafb_buffer(fb, fb->front);
+    back = vdmafb_buffer(fb, fb->back);
+    for (i = 0; i < fb->info.num_buffers - 1; i++) {
+        for (j = 0; j < fb->history[i].count; j++) {
+            vdmafb_copy_rect(fb, back, front, &fb->history[i].rects[j]);
+            vdmafb_flush_rect(fb, fb->back, &fb->history[i].rects[j]);
+        }
+    }
+    return back;
+}
+
+void vdmafb_damage(struct vdmafb *fb, const struct vdmafb_rect *rect)
+{
+    struct vdmafb_rect r;
+
+    if (vdmafb_rect_clip(fb, rect, &r))
+        vdmafb_damage_add(&fb->cur, &r);
+}
+
+static void vdmafb_timespec_add(struct timespec *ts, double sec)
+{
+    long ns = (long)(sec * 1e9);
+
+    ts->tv_nsec += ns % 1000000000L;
+    ts->tv_sec += ns / 1000000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_nsec -= 1000000000L;
+        ts->tv_sec++;
+    }
+}
+
+int vdmafb_wait_vblank(struct vdmafb *fb)
+{
+    struct timespec now;
+    __u32 crtc = 0;
+
+    if (fb->info.has_vsync)
+        return ioctl(fb->fd, FBIO_WAITFORVSYNC, &crtc);
+
+    /*驱动没有vblank时按帧周期定时,落后太多则从当前时间重新计*/
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    vdmafb_timespec_add(&fb->next_vblank, fb->info.period);
+    if (fb->next_vblank.tv_sec < now.tv_sec ||
+        (fb->next_vblank.tv_sec == now.tv_sec && fb->next_vblank.tv_nsec < now.tv_nsec)) {
+        fb->next_vblank = now;
+        return 0;
+    }
+    return clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &fb->next_vblank, NULL);
+}
+
+int vdmafb_present(struct vdmafb *fb)
+{
+    unsigned int i;
+    int ret = 0;
+
+    /*没有记录损坏区域时按整屏处理*/
+    if (!fb->cur.count)
+        vdmafb_damage_full(fb, &fb->cur);
+    for (i = 0; i < fb->cur.count; i++)
+        vdmafb_flush_rect(fb, fb->back, &fb->cur.rects[i]);
+
+    if (fb->info.num_buffers > 1) {
+        memmove(&fb->history[1], &fb->history[0],
+                sizeof(fb->history[0]) * (VDMAFB_LIB_MAX_BUFFERS - 2));
+        fb->history[0] = fb->cur;
+
+        fb->var.yoffset = fb->back * fb->info.height;
+        ret = ioctl(fb->fd, FBIOPAN_DISPLAY, &fb->var);
+        if (ret)
+            return ret;
+        fb->front = fb->back;
+    }
+    fb->cur.count = 0;
+
+    /*
+     * 翻页时必须等待vblank:旧的前台缓冲区在下一次vblank之后才不再被扫描,
+     * 之后才能作为后台缓冲区绘制
+     */
+    if (fb->info.num_buffers > 1 || !(fb->flags & VDMAFB_F_NO_VSYNC))
+        ret = vdmafb_wait_vblank(fb);
+    return ret;
+}
+
+static uint32_t vdmafb_scale(uint8_t v, unsigned int length, unsigned int offset)
+{
+    if (!length)
+        return 0;
+    return ((uint32_t)v >> (8 - (length > 8 ? 8 : length))) << offset;
+}
+
+uint32_t vdmafb_pack_color(const struct vdmafb *fb, uint8_t r, uint8_t g, uint8_t b)
+{
+    return vdmafb_scale(r, fb->info.red_length, fb->info.red_offset) |
+           vdmafb_scale(g, fb->info.green_length, fb->info.green_offset) |
+           vdmafb_scale(b, fb->info.blue_length, fb->info.blue_offset);
+}
+
+/*填充一行,像素值按小端存放*/
+static void vdmafb_fill_row(unsigned char *p, unsigned int n, unsigned int bpp, uint32_t color)
+{
+    unsigned int i = 0;
+
+    switch (bpp) {
+    case 4: {
+        uint32_t *q = (uint32_t *)p;
+#ifdef __ARM_NEON
+        uint32x4_t v = vdupq_n_u32(color);
+
+        for (; i + 8 <= n; i += 8) {
+            vst1q_u32(q + i, v);
+            vst1q_u32(q + i + 4, v);
+        }
+#endif
+        for (; i < n; i++)
+            q[i] = color;
+        break;
+    }
+    case 3: {
+#ifdef __ARM_NEON
+        /*vst3q一次交织写入16个RGB像素(48字节)*/
+        uint8x16x3_t v;
+
+        v.val[0] = vdupq_n_u8(color & 0xff);
+        v.val[1] = vdupq_n_u8((color >> 8) & 0xff);
+        v.val[2] = vdupq_n_u8((color >> 16) & 0xff);
+        for (; i + 16 <= n; i += 16)
+            vst3q_u8(p + i * 3, v);
+#endif
+        for (; i < n; i++) {
+            p[i * 3 + 0] = color & 0xff;
+            p[i * 3 + 1] = (color >> 8) & 0xff;
+            p[i * 3 + 2] = (color >> 16) & 0xff;
+        }
+        break;
+    }
+    case 2: {
+        uint16_t *q = (uint16_t *)p;
+#ifdef __ARM_NEON
+        uint16x8_t v = vdupq_n_u16(color);
+
+        for (; i + 16 <= n; i += 16) {
+            vst1q_u16(q + i, v);
+            vst1q_u16(q + i + 8, v);
+        }
+#endif
+        for (; i < n; i++)
+            q[i] = color;
+        break;
+    }
+    }
+}
+
+void vdmafb_fill(struct vdmafb *fb, void *buf, const struct vdmafb_rect *rect, uint32_t color)
+{
+    unsigned int bpp = fb->info.bytes_pp;
+    unsigned char *p;
+    struct vdmafb_rect r;
+    int y;
+
+    if (!vdmafb_rect_clip(fb, rect, &r))
+        return;
+    p = (unsigned char *)buf + (size_t)r.y * fb->info.stride + (size_t)r.x * bpp;
+    for (y = 0; y < r.h; y++, p += fb->info.stride)
+        vdmafb_fill_row(p, r.w, bpp, color);
+}
+
+/*拷贝一行;显存是写合并映射,按64字节整块写出可以充分合并*/
+static void vdmafb_copy_row(unsigned char *dst, const unsigned char *src, size_t len)
+{
+#ifdef __ARM_NEON
+    size_t i = 0;
+
+    for (; i + 64 <= len; i += 64) {
+        uint8x16_t a = vld1q_u8(src + i);
+        uint8x16_t b = vld1q_u8(src + i + 16);
+        uint8x16_t c = vld1q_u8(src + i + 32);
+        uint8x16_t d = vld1q_u8(src + i + 48);
+
+        vst1q_u8(dst + i, a);
+        vst1q_u8(dst + i + 16, b);
+        vst1q_u8(dst + i + 32, c);
+        vst1q_u8(dst + i + 48, d);
+    }
+    if (i < len)
+        memcpy(dst + i, src + i, len - i);
+#else
+    memcpy(dst, src, len);
+#endif
+}
+
+void vdmafb_blit(struct vdmafb *fb, void *buf, int dx, int dy,
+                 const void *src, unsigned int src_stride, int w, int h)
+{
+    unsigned int bpp = fb->info.bytes_pp;
+    const unsigned char *s = src;
+    unsigned char *d;
+    struct vdmafb_rect in = { dx, dy, w, h };
+    struct vdmafb_rect r;
+    int y;
+
+    if (!vdmafb_rect_clip(fb, &in, &r))
+        return;
+    /*目标被裁剪时源也相应偏移*/
+    s += (size_t)(r.y - dy) * src_stride + (size_t)(r.x - dx) * bpp;
+    d = (unsigned char *)buf + (size_t)r.y * fb->info.stride + (size_t)r.x * bpp;
+    for (y = 0; y < r.h; y++, s += src_stride, d += fb->info.stride)
+        vdmafb_copy_row(d, s, (size_t)r.w * bpp);
+}
@@ -0,0 +1,80 @@
+/*
+ * libvdmafb: framebuffer用户空间辅助库
+ *
+ * 封装打开/mmap、像素格式与行跨度、经pan切换的前后台缓冲区、
+ * 损坏区域跟踪、vblank同步,以及(NEON加速的)填充和拷贝函数.
+ * 适用于xlnx_vdmafb,也可用于其它fbdev驱动,驱动不支持的功能自动降级.
+ *
+ * 典型用法:
+ *     struct vdmafb *fb = vdmafb_open("/dev/fb0", 0);
+ *     for (;;) {
+ *         void *buf = vdmafb_begin(fb);
+ *         vdmafb_fill(fb, buf, &rect, vdmafb_pack_color(fb, 255, 0, 0));
+ *         vdmafb_damage(fb, &rect);
+ *         vdmafb_present(fb);
+ *     }
+ *
+ * 编译: $(CROSS_COMPILE)gcc -O2 -mfpu=neon -c libvdmafb.c
+ */
+#ifndef __LIBVDMAFB_H
+#define __LIBVDMAFB_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*vdmafb_open的flags*/
+#define VDMAFB_F_SINGLE_BUFFER  (1u << 0)   /*不使用pan翻页,直接画前台缓冲区*/
+#define VDMAFB_F_NO_VSYNC       (1u << 1)   /*present不等待vblank*/
+
+#define VDMAFB_MAX_DAMAGE       16          /*每帧记录的损坏矩形数,超出后合并为外接矩形*/
+
+struct vdmafb;
+
+struct vdmafb_rect {
+    int x, y;
+    int w, h;
+};
+
+struct vdmafb_info {
+    unsigned int width;             /*可见区域宽高(像素)*/
+    unsigned int height;
+    unsigned int stride;            /*行跨度(字节)*/
+    unsigned int bytes_pp;          /*每像素字节数*/
+    unsigned int bits_pp;
+    unsigned int num_buffers;       /*参与翻页的缓冲区个数,1表示单缓冲*/
+    unsigned int red_offset, red_length;
+    unsigned int green_offset, green_length;
+    unsigned int blue_offset, blue_length;
+    double period;                  /*帧周期(秒)*/
+    int has_vsync;                  /*驱动支持FBIO_WAITFORVSYNC*/
+    int has_damage;                 /*驱动支持VDMAFB_IOCTL_DAMAGE*/
+};
+
+struct vdmafb *vdmafb_open(const char *path, unsigned int flags);
+void vdmafb_close(struct vdmafb *fb);
+const struct vdmafb_info *vdmafb_get_info(const struct vdmafb *fb);
+
+/*开始一帧,返回可绘制的后台缓冲区;多缓冲时已把其它帧的改动补到该缓冲区*/
+void *vdmafb_begin(struct vdmafb *fb);
+/*记录本帧改动的区域,超出屏幕的部分被裁剪*/
+void vdmafb_damage(struct vdmafb *fb, const struct vdmafb_rect *rect);
+/*提交本帧:通知驱动损坏区域,翻页并等待vblank*/
+int vdmafb_present(struct vdmafb *fb);
+int vdmafb_wait_vblank(struct vdmafb *fb);
+
+uint32_t vdmafb_pack_color(const struct vdmafb *fb, uint8_t r, uint8_t g, uint8_t b);
+/*在buf(vdmafb_begin返回的缓冲区)中填充矩形*/
+void vdmafb_fill(struct vdmafb *fb, void *buf, const struct vdmafb_rect *rect, uint32_t color);
+/*把src(行跨度src_stride,格式与屏幕相同)拷贝到buf的(dx, dy)*/
+void vdmafb_blit(struct vdmafb *fb, void *buf, int dx, int dy,
+                 const void *src, unsigned int src_stride, int w, int h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,15 @@
+/*
+ * 仿真后端的内存登记接口
+ * 仿真的dma通道由CPU读写内存,dma地址不一定能经phys_to_virt还原(IOMMU、swiotlb),
+ * xlnx_vdmafb把显存和抓屏缓冲区的dma地址与分配时得到的CPU地址登记到这里,
+ * 由vdmafb_sim.c实现,SIM=1编译时使用
+ */
+#ifndef __VDMAFB_SIM_H__
+#define __VDMAFB_SIM_H__
+
+#include <linux/types.h>
+
+void vdmafb_sim_add_region(dma_addr_t dma, void *virt, size_t len);
+void vdmafb_sim_del_region(dma_addr_t dma);
+
+#endif
@@ -0,0 +1,31 @@
+/*
+ * 仿真后端的VTC接口
+ * 与drivers/media/platform/xilinx/xilinx-vtc.h保持同样的接口,
+ * 由vdmafb_sim.c实现,SIM=1编译时替代真实的VTC驱动
+ */
+#ifndef __XILINX_VTC_SIM_H__
+#define __XILINX_VTC_SIM_H__
+
+struct device_node;
+struct xvtc_device;
+
+struct xvtc_config {
+    unsigned int hblank_start;
+    unsigned int hsync_start;
+    unsigned int hsync_end;
+    unsigned int hsize;
+    unsigned int vblank_start;
+    unsigned int vsync_start;
+    unsigned int vsync_end;
+    unsigned int vsize;
+    unsigned int fps;
+};
+
+struct xvtc_device *xvtc_of_get(struct device_node *np);
+void xvtc_put(struct xvtc_device *xvtc);
+
+int xvtc_generator_start(struct xvtc_device *xvtc,
+                         const struct xvtc_config *config);
+int xvtc_generator_stop(struct xvtc_device *xvtc);
+
+#endif
@@ -1,5 +1,19 @@
-#include "linux/signal.h"
-#include <asm-generic/int-ll64.h>
+/*
+ * framebuffer测试/性能测试程序
+ *
+ * test_app [-d /dev/fbN] demo
+ *     循环显示两幅测试图案(原有功能,要求24位色)
+ * test_app [-d /dev/fbN] bench [-t 秒] [-o 输出.csv]
+ *     测试memset填充、按行图案填充、显存内拷贝、回读的MB/s与帧率
+ *     (各区域分别按驱动行跨度、紧凑行跨度和4KB对齐行跨度),
+ *     以及pan/vsync延迟,结果以CSV输出.
+ *     可在vfb或xlnx_vdmafb仿真后端(make SIM=1)上运行,用于回归对比.
+ * test_app [-d /dev/fbN] soak [-t 秒] [-m 允许丢帧数] [-l 负载线程数] [-c] [-o 报告]
+ *     以面板刷新率长时间运行动画,输出帧时间直方图、丢帧数和撕裂检测结果,
+ *     用于发布前的稳定性验收,不合格时返回非0
+ *
+ * 编译: $(CROSS_COMPILE)gcc -O2 -Wall -o test_app test_app.c -lpthread
+ */
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -8,8 +22,27 @@
 #include <linux/fb.h>
 #include <sys/mman.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include "xlnx_vdmafb.h"
 
+#ifndef FBIO_WAITFORVSYNC
+#define FBIO_WAITFORVSYNC _IOW('F', 0x20, __u32)
+#endif
+
+struct fb_dev {
+    int fd;
+    struct fb_var_screeninfo vinfo;     //可变参数
+    struct fb_fix_screeninfo finfo;     //固定参数
+    unsigned char *base;                //映射基地址
+    unsigned int size;                  //映射大小
+    unsigned int bpp;                   //每像素字节数
+};
 
 static void display_demo_1 (unsigned char *frame, unsigned int width, unsigned int height, unsigned int stride)
 {
@@ -101,62 +134,966 @@ wRed = 0;
  }
  }
 
-
-int main(int argc,char **argv)
+static int fb_open(struct fb_dev *fb, const char *path)
 {
-    int fd;
-    struct fb_var_screeninfo vinfo; //可变参数
-    struct fb_fix_screeninfo finfo; //固定参数
-    unsigned int screensize;                //屏幕大小
-    unsigned char *base;                       //映射基地址
-
     int ret;
-    
-    fd = open("/dev/fb0",O_RDWR);
-    if(fd<0)
+
+    fb->fd = open(path,O_RDWR);
+    if(fb->fd<0)
     {
-        printf("Error: cannot open framebuffer device.\n");
-        return fd;
+        printf("Error: cannot open framebuffer device %s.\n", path);
+        return -1;
     }
 
     /*获取frambuffer设备信息*/
-    ret = ioctl(fd,FBIOGET_FSCREENINFO,&finfo);
+    ret = ioctl(fb->fd,FBIOGET_FSCREENINFO,&fb->finfo);
     if(ret)
     {
         printf("Error reading fixed information\n");
         return ret;
     }
-    ret = ioctl(fd,FBIOGET_VSCREENINFO,&vinfo);
+    ret = ioctl(fb->fd,FBIOGET_VSCREENINFO,&fb->vinfo);
     if(ret)
     {
         printf("Error reading variable information\n");
         return ret;
     }
+    fb->bpp = (fb->vinfo.bits_per_pixel + 7) / 8;
 
-    /*mmap映射*/
-    screensize = vinfo.yres_virtual * finfo.line_length;
-    base = (unsigned char *)mmap(NULL,screensize,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
-    if((int)base == -1)
+    /*mmap映射,包含所有缓冲区*/
+    fb->size = fb->vinfo.yres_virtual * fb->finfo.line_length;
+    fb->base = (unsigned char *)mmap(NULL,fb->size,PROT_READ | PROT_WRITE,MAP_SHARED,fb->fd,0);
+    if(fb->base == MAP_FAILED)
     {
         printf("Error: failed to map framebuffer device to memory.\n");
         return -1;
     }
+    return 0;
+}
+
+static void fb_close(struct fb_dev *fb)
+{
+    munmap(fb->base,fb->size);
+    close(fb->fd);
+}
+
+static int run_demo(struct fb_dev *fb)
+{
+    if (fb->bpp != 3) {
+        printf("Error: demo patterns need a 24bpp framebuffer (got %u bpp)\n",
+               fb->vinfo.bits_per_pixel);
+        return -1;
+    }
 
-    memset(base,0,screensize);
+    memset(fb->base,0,fb->size);
 
     for(;;)
     {
-        display_demo_1(base,vinfo.xres,vinfo.yres,finfo.line_length);
+        display_demo_1(fb->base,fb->vinfo.xres,fb->vinfo.yres,fb->finfo.line_length);
         sleep(1);
-        display_demo_2(base,vinfo.xres,vinfo.yres,finfo.line_length);
+        display_demo_2(fb->base,fb->vinfo.xres,fb->vinfo.yres,fb->finfo.line_length);
         sleep(1);
     }
+    return 0;
+}
+
+/*---------------------------------- bench ----------------------------------*/
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*测试区域,w_div为0表示64x64的小块*/
+struct bench_region {
+    const char *name;
+    unsigned int w_div;         //宽 = xres / w_div
+    unsigned int h_div;         //高 = yres / h_div
+    unsigned int x_off;         //起始列(像素),非0时行首不对齐
+};
+
+static const struct bench_region bench_regions[] = {
+    { "full",         1, 1, 0 },
+    { "full_unalign", 1, 1, 1 },
+    { "half",         2, 2, 0 },
+    { "quarter",      4, 4, 0 },
+    { "tile64",       0, 0, 0 },    //64x64
+    { "tile64_unal",  0, 0, 3 },
+};
+
+struct bench_ctx {
+    struct fb_dev *fb;
+    FILE *out;
+    double min_time;            //每项测试的最短运行时间
+    unsigned char *row;         //一行图案
+    unsigned char *shadow;      //回读目标
+};
+
+struct bench_rect {
+    unsigned int x, y, w, h;
+    unsigned int stride;        //行跨度(字节)
+};
+
+/*
+ * 行跨度:显存的物理行跨度固定,这里改变软件访问显存时的行间距,
+ * 测量行跨度对写合并、缓存行和页边界的影响
+ */
+enum bench_stride_mode {
+    BENCH_STRIDE_NATIVE,        //驱动的line_length
+    BENCH_STRIDE_PACKED,        //区域行字节数,行间无空隙
+    BENCH_STRIDE_PAGE,          //line_length按4KB向上对齐,每行起始于新页
+};
+
+static const char *const bench_stride_names[] = { "native", "packed", "page" };
+
+static void bench_rect_of(struct fb_dev *fb, const struct bench_region *r, struct bench_rect *rc)
+{
+    if (r->w_div == 0) {
+        rc->w = 64;
+        rc->h = 64;
+    } else {
+        rc->w = fb->vinfo.xres / r->w_div;
+        rc->h = fb->vinfo.yres / r->h_div;
+    }
+    rc->x = r->x_off;
+    rc->y = 0;
+    if (rc->x + rc->w > fb->vinfo.xres)
+        rc->w = fb->vinfo.xres - rc->x;
+}
+
+static unsigned int bench_stride_of(struct fb_dev *fb, int mode, const struct bench_rect *rc)
+{
+    switch (mode) {
+    case BENCH_STRIDE_PACKED:
+        return rc->w * fb->bpp;
+    case BENCH_STRIDE_PAGE:
+        return (fb->finfo.line_length + 4095) & ~4095u;
+    default:
+        return fb->finfo.line_length;
+    }
+}
+
+/*按区域的行跨度,映射内从第0行起能容纳的行数*/
+static unsigned int bench_rows_fit(struct fb_dev *fb, const struct bench_rect *rc)
+{
+    size_t first = (size_t)rc->x * fb->bpp + (size_t)rc->w * fb->bpp;
+
+    if (fb->size < first)
+        return 0;
+    return (fb->size - first) / rc->stride + 1;
+}
+
+static inline unsigned char *bench_pixel(struct fb_dev *fb, const struct bench_rect *rc,
+                                         unsigned int x, unsigned int y)
+{
+    return fb->base + (size_t)y * rc->stride + (size_t)x * fb->bpp;
+}
+
+typedef void (*bench_fn)(struct bench_ctx *ctx, const struct bench_rect *rc, unsigned int iter);
+
+/*整块memset填充;区域为整行且stride无填充时一次memset完成*/
+static void bench_memset(struct bench_ctx *ctx, const struct bench_rect *rc, unsigned int iter)
+{
+    struct fb_dev *fb = ctx->fb;
+    size_t row_bytes = (size_t)rc->w * fb->bpp;
+    unsigned int y;
+
+    if (rc->x == 0 && row_bytes == rc->stride) {
+        memset(bench_pixel(fb, rc, 0, rc->y), iter & 0xff, row_bytes * rc->h);
+        return;
+    }
+    for (y = 0; y < rc->h; y++)
+        memset(bench_pixel(fb, rc, rc->x, rc->y + y), iter & 0xff, row_bytes);
+}
+
+/*按行图案填充:每行从预先生成的图案行拷贝,模拟软件渲染的输出写入*/
+static void bench_pattern(struct bench_ctx *ctx, const struct bench_rect *rc, unsigned int iter)
+{
+    struct fb_dev *fb = ctx->fb;
+    size_t row_bytes = (size_t)rc->w * fb->bpp;
+    unsigned int y;
+
+    for (y = 0; y < rc->h; y++) {
+        unsigned int shift = ((y + iter) & 0x3f) * fb->bpp;
+        memcpy(bench_pixel(fb, rc, rc->x, rc->y + y), ctx->row + shift, row_bytes);
+    }
+}
+
+/*
+ * 显存内拷贝:把区域拷贝到其下方等大的区域,即读显存+写显存
+ * 映射放不下时(如单缓冲的全屏区域)在区域内做一行的滚动,只拷贝h-1行,不越过映射末尾
+ */
+static void bench_copy(struct bench_ctx *ctx, const struct bench_rect *rc, unsigned int iter)
+{
+    struct fb_dev *fb = ctx->fb;
+    size_t row_bytes = (size_t)rc->w * fb->bpp;
+    unsigned int dst_y = rc->y + rc->h;
+    unsigned int rows = rc->h;
+    unsigned int y;
+
+    (void)iter;
+    if (dst_y + rc->h > bench_rows_fit(fb, rc)) {
+        dst_y = rc->y + 1;
+        rows = rc->h - 1;
+    }
+    for (y = rows; y-- > 0; )   //自下而上,源与目的重叠时不会覆盖未拷贝的行
+        memmove(bench_pixel(fb, rc, rc->x, dst_y + y), bench_pixel(fb, rc, rc->x, rc->y + y),
+                row_bytes);
+}
+
+/*回读:显存通常为写合并/非缓存映射,读带宽远低于写*/
+static void bench_readback(struct bench_ctx *ctx, const struct bench_rect *rc, unsigned int iter)
+{
+    struct fb_dev *fb = ctx->fb;
+    size_t row_bytes = (size_t)rc->w * fb->bpp;
+    unsigned int y;
+
+    (void)iter;
+    for (y = 0; y < rc->h; y++)
+        memcpy(ctx->shadow + y * row_bytes, bench_pixel(fb, rc, rc->x, rc->y + y), row_bytes);
+}
+
+static const struct {
+    const char *name;
+    bench_fn fn;
+} bench_tests[] = {
+    { "memset",   bench_memset },
+    { "pattern",  bench_pattern },
+    { "copy",     bench_copy },
+    { "readback", bench_readback },
+};
+
+static void bench_csv_header(FILE *out)
+{
+    fprintf(out, "test,region,stride_mode,x,y,width,height,stride,bpp,bytes_per_iter,iters,seconds,"
+                 "mb_per_s,frames_per_s,lat_min_us,lat_avg_us,lat_max_us\n");
+}
 
-    memset(base,0,screensize); 
-    munmap(base,screensize);
-    close(fd);
+static void bench_run_throughput(struct bench_ctx *ctx)
+{
+    struct fb_dev *fb = ctx->fb;
+    unsigned int t, r, m;
+
+    for (t = 0; t < sizeof(bench_tests) / sizeof(bench_tests[0]); t++) {
+        for (r = 0; r < sizeof(bench_regions) / sizeof(bench_regions[0]); r++) {
+        for (m = 0; m < sizeof(bench_stride_names) / sizeof(bench_stride_names[0]); m++) {
+            struct bench_rect rc;
+            unsigned int iters = 0;
+            double start, elapsed;
+            size_t bytes;
+
+            bench_rect_of(fb, &bench_regions[r], &rc);
+            if (rc.w == 0 || rc.h == 0)
+                continue;
+            rc.stride = bench_stride_of(fb, m, &rc);
+            /*其它行跨度与驱动行跨度相同时不重复测量;映射放不下时跳过*/
+            if (m != BENCH_STRIDE_NATIVE && rc.stride == fb->finfo.line_length)
+                continue;
+            if (bench_rows_fit(fb, &rc) < rc.h)
+                continue;
+            bytes = (size_t)rc.w * rc.h * fb->bpp;
+
+            /*预热一次,排除缺页等一次性开销*/
+            bench_tests[t].fn(ctx, &rc, 0);
+
+            start = now_sec();
+            do {
+                bench_tests[t].fn(ctx, &rc, ++iters);
+                elapsed = now_sec() - start;
+            } while (elapsed < ctx->min_time);
+
+            fprintf(ctx->out, "%s,%s,%s,%u,%u,%u,%u,%u,%u,%zu,%u,%.6f,%.2f,%.2f,,,\n",
+                    bench_tests[t].name, bench_regions[r].name, bench_stride_names[m],
+                    rc.x, rc.y, rc.w, rc.h, rc.stride, fb->vinfo.bits_per_pixel, bytes,
+                    iters, elapsed, (double)bytes * iters / elapsed / 1e6, iters / elapsed);
+            fflush(ctx->out);
+        }
+        }
+    }
+}
+
+struct lat_stat {
+    unsigned int n;
+    double min, max, sum;
+};
+
+static void lat_add(struct lat_stat *s, double v)
+{
+    if (s->n == 0 || v < s->min)
+        s->min = v;
+    if (s->n == 0 || v > s->max)
+        s->max = v;
+    s->sum += v;
+    s->n++;
+}
+
+static void lat_print(struct bench_ctx *ctx, const char *name, struct lat_stat *s, double elapsed)
+{
+    struct fb_dev *fb = ctx->fb;
+
+    fprintf(ctx->out, "%s,full,native,0,0,%u,%u,%u,%u,,%u,%.6f,,%.2f,%.1f,%.1f,%.1f\n",
+            name, fb->vinfo.xres, fb->vinfo.yres, fb->finfo.line_length,
+            fb->vinfo.bits_per_pixel, s->n, elapsed, s->n / elapsed,
+            s->min * 1e6, s->sum / s->n * 1e6, s->max * 1e6);
+    fflush(ctx->out);
+}
+
+/*
+ * 延迟测试
+ * vsync:     连续FBIO_WAITFORVSYNC,间隔即帧周期
+ * pan:       FBIOPAN_DISPLAY调用本身的耗时
+ * pan_vsync: pan之后到下一次vblank的时间,即翻页生效延迟
+ * 驱动不支持相应ioctl时跳过该项
+ */
+static void bench_run_latency(struct bench_ctx *ctx)
+{
+    struct fb_dev *fb = ctx->fb;
+    struct fb_var_screeninfo var = fb->vinfo;
+    unsigned int nbuf = fb->vinfo.yres ? fb->vinfo.yres_virtual / fb->vinfo.yres : 1;
+    struct lat_stat vs = {0}, pan = {0}, pv = {0};
+    struct vdmafb_vblank_info vbi;
+    double start, t0, t1;
+    __u32 crtc = 0;
+    int have_vsync;
+    unsigned int i = 0;
+
+    have_vsync = ioctl(fb->fd, FBIO_WAITFORVSYNC, &crtc) == 0;
+    if (!have_vsync)
+        fprintf(stderr, "FBIO_WAITFORVSYNC not supported (%s), skipping vsync tests\n",
+                strerror(errno));
+
+    if (have_vsync) {
+        start = t0 = now_sec();
+        do {
+            if (ioctl(fb->fd, FBIO_WAITFORVSYNC, &crtc))
+                break;
+            t1 = now_sec();
+            lat_add(&vs, t1 - t0);
+            t0 = t1;
+        } while (t1 - start < ctx->min_time);
+        if (vs.n)
+            lat_print(ctx, "vsync", &vs, t0 - start);
+    }
+
+    if (nbuf < 2 || fb->finfo.ypanstep == 0) {
+        fprintf(stderr, "single buffer or no ypanstep, skipping pan tests\n");
+    } else {
+        start = now_sec();
+        do {
+            var.yoffset = (++i % nbuf) * fb->vinfo.yres;
+            t0 = now_sec();
+            if (ioctl(fb->fd, FBIOPAN_DISPLAY, &var)) {
+                fprintf(stderr, "FBIOPAN_DISPLAY failed: %s\n", strerror(errno));
+                break;
+            }
+            t1 = now_sec();
+            lat_add(&pan, t1 - t0);
+            if (have_vsync) {
+                if (ioctl(fb->fd, FBIO_WAITFORVSYNC, &crtc))
+                    break;
+                lat_add(&pv, now_sec() - t0);
+            }
+        } while (now_sec() - start < ctx->min_time);
+        t1 = now_sec();
+        if (pan.n)
+            lat_print(ctx, "pan", &pan, t1 - start);
+        if (pv.n)
+            lat_print(ctx, "pan_vsync", &pv, t1 - start);
+
+        var.yoffset = 0;
+        ioctl(fb->fd, FBIOPAN_DISPLAY, &var);
+    }
+
+    /*xlnx_vdmafb驱动报告的帧周期,用于与测得的vsync间隔对照*/
+    if (ioctl(fb->fd, VDMAFB_IOCTL_GET_VBLANK, &vbi) == 0)
+        fprintf(stderr, "driver vblank: seq %llu period %.1f us\n",
+                (unsigned long long)vbi.sequence, vbi.period_ns / 1e3);
+}
+
+static int run_bench(struct fb_dev *fb, int argc, char **argv)
+{
+    struct bench_ctx ctx = {0};
+    const char *out_path = NULL;
+    size_t row_max;
+    unsigned int i;
+    int opt;
+
+    ctx.fb = fb;
+    ctx.out = stdout;
+    ctx.min_time = 1.0;
+
+    optind = 1;
+    while ((opt = getopt(argc, argv, "t:o:")) != -1) {
+        switch (opt) {
+        case 't':
+            ctx.min_time = atof(optarg);
+            break;
+        case 'o':
+            out_path = optarg;
+            break;
+        default:
+            printf("Usage: bench [-t seconds_per_test] [-o out.csv]\n");
+            return -1;
+        }
+    }
+
+    if (out_path) {
+        ctx.out = fopen(out_path, "w");
+        if (!ctx.out) {
+            printf("Error: cannot open %s\n", out_path);
+            return -1;
+        }
+    }
+
+    /*图案行多留64像素,按行错位拷贝形成斜纹*/
+    row_max = (size_t)(fb->vinfo.xres + 64) * fb->bpp;
+    ctx.row = malloc(row_max);
+    ctx.shadow = malloc((size_t)fb->vinfo.xres * fb->vinfo.yres * fb->bpp);
+    if (!ctx.row || !ctx.shadow) {
+        printf("Error: out of memory\n");
+        return -1;
+    }
+    for (i = 0; i < row_max; i++)
+        ctx.row[i] = ((i / fb->bpp) & 0x20) ? 0xff : 0x00;
+
+    fprintf(stderr, "%s: %ux%u (virtual %ux%u), %u bpp, stride %u, smem %u bytes\n",
+            fb->finfo.id, fb->vinfo.xres, fb->vinfo.yres, fb->vinfo.xres_virtual,
+            fb->vinfo.yres_virtual, fb->vinfo.bits_per_pixel, fb->finfo.line_length,
+            fb->finfo.smem_len);
+
+    bench_csv_header(ctx.out);
+    bench_run_throughput(&ctx);
+    bench_run_latency(&ctx);
+
+    if (ctx.out != stdout)
+        fclose(ctx.out);
+    free(ctx.row);
+    free(ctx.shadow);
     return 0;
+}
+
+/*---------------------------------- soak -----------------------------------*/
 
+/*
+ * 长时间动画稳定性测试
+ * 以面板刷新率渲染移动图案:有多缓冲和vsync时渲染到后台缓冲区再pan翻页,
+ * 否则直接画前台并按帧周期定时.每帧的渲染时间、提交时间(pan到vblank)和
+ * 帧间隔记入直方图,并统计丢失的vblank.
+ * -c 时在每帧首末两行嵌入帧号标记,由抓屏线程通过驱动的抓屏接口取回前台
+ * 缓冲区,首末行帧号不一致即为撕裂.
+ * 驱动在vblank时用DMA拷贝刚扫描完的缓冲区.三缓冲以上时下一帧画到两个vblank前
+ * 释放的缓冲区,拷贝早已完成;双缓冲时下一帧正好画到刚释放的缓冲区,须等该vblank
+ * 的抓屏取回后再渲染,否则拷贝与渲染竞争,会误报撕裂.
+ */
+#define HIST_BIN_US     250
+#define HIST_BINS       200     //0~50ms,超出的计入最后一格
 
+#define MARKER_BITS     32
+#define MARKER_BLOCK    8       //每位占8个像素宽
+#define MARKER_ROWS     2       //标记占用的行数
 
-}
\ No newline at end of file
+struct hist {
+    unsigned long bins[HIST_BINS + 1];
+    unsigned long n;
+    double sum;
+    double max;
+};
+
+static void hist_add(struct hist *h, double sec)
+{
+    unsigned long bin = (unsigned long)(sec * 1e6 / HIST_BIN_US);
+
+    h->bins[bin < HIST_BINS ? bin : HIST_BINS]++;
+    h->n++;
+    h->sum += sec;
+    if (sec > h->max)
+        h->max = sec;
+}
+
+/*由直方图估计百分位,返回所在格的上沿(ms)*/
+static double hist_pct(const struct hist *h, double pct)
+{
+    unsigned long want = (unsigned long)(h->n * pct / 100.0);
+    unsigned long acc = 0;
+    unsigned int i;
+
+    for (i = 0; i <= HIST_BINS; i++) {
+        acc += h->bins[i];
+        if (acc > want)
+            break;
+    }
+    if (i >= HIST_BINS)
+        return h->max * 1e3;
+    return (i + 1) * HIST_BIN_US / 1e3;
+}
+
+static void hist_print(FILE *out, const char *name, const struct hist *h)
+{
+    unsigned int i;
+
+    if (!h->n)
+        return;
+    fprintf(out, "%-10s avg %7.3f ms  p50 %7.3f  p99 %7.3f  p99.9 %7.3f  max %7.3f ms\n",
+            name, h->sum / h->n * 1e3, hist_pct(h, 50), hist_pct(h, 99),
+            hist_pct(h, 99.9), h->max * 1e3);
+    for (i = 0; i <= HIST_BINS; i++) {
+        if (!h->bins[i])
+            continue;
+        if (i < HIST_BINS)
+            fprintf(out, "    %6.2f-%6.2f ms: %lu\n", i * HIST_BIN_US / 1e3,
+                    (i + 1) * HIST_BIN_US / 1e3, h->bins[i]);
+        else
+            fprintf(out, "    >%12.2f ms: %lu\n", i * HIST_BIN_US / 1e3, h->bins[i]);
+    }
+}
+
+struct soak_ctx {
+    struct fb_dev *fb;
+    unsigned int nbuf;
+    double period;              //帧周期(秒)
+    double duration;
+    int have_vsync;
+    int have_vblank_info;
+    volatile int stop;
+
+    unsigned char *row;         //背景图案行
+
+    struct hist render;
+    struct hist present;
+    struct hist interval;
+    unsigned long frames;
+    unsigned long missed;       //丢失的vblank
+
+    /*抓屏校验*/
+    int check_capture;
+    pthread_t cap_thread;
+    unsigned long cap_frames;
+    unsigned long cap_torn;
+    unsigned long cap_repeat;   //与上一张抓屏帧号相同,即该vblank没有新帧
+    unsigned long cap_skipped;  //帧号跳跃,渲染的帧从未被显示
+    pthread_mutex_t cap_lock;
+    pthread_cond_t cap_cond;
+    uint64_t cap_vblank;        //最近取回的抓屏对应的vblank计数,抓屏停止后为UINT64_MAX
+};
+
+static volatile int soak_interrupted;
+
+static void soak_sigint(int sig)
+{
+    (void)sig;
+    soak_interrupted = 1;
+}
+
+static void soak_put_marker(struct soak_ctx *ctx, unsigned char *frame, unsigned int y, uint32_t val)
+{
+    struct fb_dev *fb = ctx->fb;
+    size_t block = (size_t)MARKER_BLOCK * fb->bpp;
+    unsigned int r, b;
+
+    for (r = 0; r < MARKER_ROWS; r++) {
+        unsigned char *p = frame + (size_t)(y + r) * fb->finfo.line_length;
+
+        for (b = 0; b < MARKER_BITS; b++)
+            memset(p + b * block, (val >> b) & 1 ? 0xff : 0x00, block);
+    }
+}
+
+static uint32_t soak_get_marker(struct soak_ctx *ctx, const unsigned char *frame, unsigned int y)
+{
+    struct fb_dev *fb = ctx->fb;
+    const unsigned char *p = frame + (size_t)y * fb->finfo.line_length;
+    uint32_t val = 0;
+    unsigned int b;
+
+    /*取每个色块中间像素的第一个字节*/
+    for (b = 0; b < MARKER_BITS; b++)
+        if (p[(b * MARKER_BLOCK + MARKER_BLOCK / 2) * fb->bpp] >= 0x80)
+            val |= 1u << b;
+    return val;
+}
+
+/*渲染一帧:斜纹背景随帧号滚动,加一条水平移动的竖条*/
+static void soak_render(struct soak_ctx *ctx, unsigned char *frame, unsigned long n)
+{
+    struct fb_dev *fb = ctx->fb;
+    unsigned int xres = fb->vinfo.xres, yres = fb->vinfo.yres;
+    size_t row_bytes = (size_t)xres * fb->bpp;
+    unsigned int bar_w = xres / 16 ? xres / 16 : 1;
+    unsigned int bar_x = (n * 8) % xres;
+    unsigned int y;
+
+    if (bar_x + bar_w > xres)
+        bar_x = xres - bar_w;
+    for (y = 0; y < yres; y++) {
+        unsigned char *p = frame + (size_t)y * fb->finfo.line_length;
+
+        memcpy(p, ctx->row + ((y + n) & 0x3f) * fb->bpp, row_bytes);
+        memset(p + (size_t)bar_x * fb->bpp, 0x80, (size_t)bar_w * fb->bpp);
+    }
+    if (ctx->check_capture && yres > 2 * MARKER_ROWS &&
+        xres >= MARKER_BITS * MARKER_BLOCK) {
+        soak_put_marker(ctx, frame, 0, (uint32_t)n);
+        soak_put_marker(ctx, frame, yres - MARKER_ROWS, (uint32_t)n);
+    }
+}
+
+/*记录已取回的抓屏,唤醒等待该vblank拷贝完成的渲染循环*/
+static void soak_capture_done(struct soak_ctx *ctx, uint64_t vblank)
+{
+    pthread_mutex_lock(&ctx->cap_lock);
+    ctx->cap_vblank = vblank;
+    pthread_cond_broadcast(&ctx->cap_cond);
+    pthread_mutex_unlock(&ctx->cap_lock);
+}
+
+/*等待vblank计数为seq的抓屏取回,最多等待timeout秒(该vblank可能未抓取)*/
+static void soak_wait_capture(struct soak_ctx *ctx, uint64_t seq, double timeout)
+{
+    struct timespec ts;
+    double deadline = now_sec() + timeout;
+
+    ts.tv_sec = (time_t)deadline;
+    ts.tv_nsec = (long)((deadline - ts.tv_sec) * 1e9);
+    pthread_mutex_lock(&ctx->cap_lock);
+    while (ctx->cap_vblank < seq) {
+        if (pthread_cond_timedwait(&ctx->cap_cond, &ctx->cap_lock, &ts) == ETIMEDOUT)
+            break;
+    }
+    pthread_mutex_unlock(&ctx->cap_lock);
+}
+
+static void *soak_capture_thread(void *arg)
+{
+    struct soak_ctx *ctx = arg;
+    struct fb_dev *fb = ctx->fb;
+    struct vdmafb_capture_start req = {0};
+    struct vdmafb_capture_buf buf;
+    unsigned char *map;
+    uint32_t last = 0;
+    int have_last = 0;
+
+    req.mode = VDMAFB_CAPTURE_CONTINUOUS;
+    req.interval = 1;
+    req.count = 4;
+    if (ioctl(fb->fd, VDMAFB_IOCTL_CAPTURE_START, &req)) {
+        fprintf(stderr, "capture not supported (%s), tear check disabled\n", strerror(errno));
+        soak_capture_done(ctx, UINT64_MAX);
+        return NULL;
+    }
+    map = mmap(NULL, (size_t)req.buf_size * req.count, PROT_READ, MAP_SHARED,
+               fb->fd, req.mmap_offset);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "capture mmap failed (%s), tear check disabled\n", strerror(errno));
+        ioctl(fb->fd, VDMAFB_IOCTL_CAPTURE_STOP);
+        soak_capture_done(ctx, UINT64_MAX);
+        return NULL;
+    }
+
+    while (!ctx->stop) {
+        const unsigned char *frame;
+        uint32_t top, bottom;
+
+        if (ioctl(fb->fd, VDMAFB_IOCTL_CAPTURE_DQBUF, &buf)) {
+            /*EAGAIN: 100ms内没有新帧或抓屏已停止,稍后重试*/
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN) {
+                usleep(1000);
+                continue;
+            }
+            fprintf(stderr, "capture DQBUF failed (%s), tear check stopped\n", strerror(errno));
+            break;
+        }
+        soak_capture_done(ctx, buf.vblank);
+        /*动画开始前抓到的是旧内容,不做校验*/
+        if (ctx->frames < 2) {
+            ioctl(fb->fd, VDMAFB_IOCTL_CAPTURE_QBUF, &buf.index);
+            continue;
+        }
+        frame = map + (size_t)buf.index * req.buf_size;
+        top = soak_get_marker(ctx, frame, 0);
+        bottom = soak_get_marker(ctx, frame, fb->vinfo.yres - MARKER_ROWS);
+        ctx->cap_frames++;
+        if (top != bottom)
+            ctx->cap_torn++;
+        else if (have_last && top == last)
+            ctx->cap_repeat++;
+        else if (have_last && top != last + 1)
+            ctx->cap_skipped++;
+        last = top;
+        have_last = 1;
+        ioctl(fb->fd, VDMAFB_IOCTL_CAPTURE_QBUF, &buf.index);
+    }
+
+    ioctl(fb->fd, VDMAFB_IOCTL_CAPTURE_STOP);
+    munmap(map, (size_t)req.buf_size * req.count);
+    soak_capture_done(ctx, UINT64_MAX);
+    return NULL;
+}
+
+/*占用CPU的负载线程,模拟应用的其它工作*/
+static void *soak_load_thread(void *arg)
+{
+    struct soak_ctx *ctx = arg;
+    volatile unsigned long x = 0;
+
+    while (!ctx->stop)
+        x++;
+    return NULL;
+}
+
+/*由显示时序估算帧周期,驱动或时序无效时按60Hz*/
+static double soak_period(struct fb_dev *fb)
+{
+    struct fb_var_screeninfo *v = &fb->vinfo;
+    struct vdmafb_vblank_info vbi;
+    double htotal, vtotal;
+
+    if (ioctl(fb->fd, VDMAFB_IOCTL_GET_VBLANK, &vbi) == 0 && vbi.period_ns)
+        return vbi.period_ns / 1e9;
+    htotal = v->xres + v->left_margin + v->right_margin + v->hsync_len;
+    vtotal = v->yres + v->upper_margin + v->lower_margin + v->vsync_len;
+    if (v->pixclock)
+        return htotal * vtotal * v->pixclock * 1e-12;
+    return 1.0 / 60;
+}
+
+static void soak_summary(struct soak_ctx *ctx, FILE *out, double elapsed, unsigned long max_missed)
+{
+    struct fb_dev *fb = ctx->fb;
+    int pass = ctx->missed <= max_missed && ctx->cap_torn == 0;
+
+    fprintf(out, "device:      %s %ux%u %u bpp, %u buffer(s)\n", fb->finfo.id,
+            fb->vinfo.xres, fb->vinfo.yres, fb->vinfo.bits_per_pixel, ctx->nbuf);
+    fprintf(out, "mode:        %s\n", ctx->have_vsync ?
+            (ctx->nbuf > 1 ? "pan flip + vsync" : "single buffer + vsync") :
+            "single buffer, timer paced");
+    fprintf(out, "duration:    %.1f s\n", elapsed);
+    fprintf(out, "period:      %.3f ms (%.2f Hz)\n", ctx->period * 1e3, 1 / ctx->period);
+    fprintf(out, "frames:      %lu (%.2f fps)\n", ctx->frames, ctx->frames / elapsed);
+    fprintf(out, "missed:      %lu vblank(s)%s\n", ctx->missed,
+            ctx->have_vblank_info ? "" : " (estimated from frame interval)");
+    if (ctx->check_capture)
+        fprintf(out, "capture:     %lu frames, %lu torn, %lu repeated, %lu skipped\n",
+                ctx->cap_frames, ctx->cap_torn, ctx->cap_repeat, ctx->cap_skipped);
+    hist_print(out, "render", &ctx->render);
+    hist_print(out, "present", &ctx->present);
+    hist_print(out, "interval", &ctx->interval);
+    fprintf(out, "result:      %s\n", pass ? "PASS" : "FAIL");
+}
+
+static int run_soak(struct fb_dev *fb, int argc, char **argv)
+{
+    struct soak_ctx *ctx;
+    pthread_condattr_t cattr;
+    struct fb_var_screeninfo var = fb->vinfo;
+    struct vdmafb_vblank_info vbi;
+    const char *out_path = NULL;
+    unsigned long max_missed = 0;
+    unsigned int nload = 0;
+    pthread_t *load = NULL;
+    double start, last_vblank, next_deadline, t0, t1, t2;
+    uint64_t last_seq = 0;
+    __u32 crtc = 0;
+    size_t row_max;
+    unsigned int i, back = 0;
+    int opt, ret = 0;
+
+    ctx = calloc(1, sizeof(*ctx));
+    if (!ctx)
+        return -1;
+    ctx->fb = fb;
+    ctx->duration = 3600;
+    pthread_mutex_init(&ctx->cap_lock, NULL);
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);     //与now_sec()同一时钟
+    pthread_cond_init(&ctx->cap_cond, &cattr);
+    pthread_condattr_destroy(&cattr);
+
+    optind = 1;
+    while ((opt = getopt(argc, argv, "t:m:l:o:c")) != -1) {
+        switch (opt) {
+        case 't':
+            ctx->duration = atof(optarg);
+            break;
+        case 'm':
+            max_missed = strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            nload = strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            out_path = optarg;
+            break;
+        case 'c':
+            ctx->check_capture = 1;
+            break;
+        default:
+            printf("Usage: soak [-t seconds] [-m max_missed] [-l load_threads] [-c] [-o summary.txt]\n");
+            free(ctx);
+            return -1;
+        }
+    }
+
+    ctx->nbuf = fb->vinfo.yres ? fb->vinfo.yres_virtual / fb->vinfo.yres : 1;
+    if (fb->finfo.ypanstep == 0)
+        ctx->nbuf = 1;
+    ctx->have_vsync = ioctl(fb->fd, FBIO_WAITFORVSYNC, &crtc) == 0;
+    ctx->have_vblank_info = ioctl(fb->fd, VDMAFB_IOCTL_GET_VBLANK, &vbi) == 0;
+    ctx->period = soak_period(fb);
+    if (ctx->have_vblank_info)
+        last_seq = vbi.sequence;
+
+    row_max = (size_t)(fb->vinfo.xres + 64) * fb->bpp;
+    ctx->row = malloc(row_max);
+    if (!ctx->row) {
+        free(ctx);
+        return -1;
+    }
+    for (i = 0; i < row_max; i++)
+        ctx->row[i] = ((i / fb->bpp) & 0x20) ? 0xe0 : 0x20;
+
+    signal(SIGINT, soak_sigint);
+    if (ctx->check_capture)
+        pthread_create(&ctx->cap_thread, NULL, soak_capture_thread, ctx);
+    if (nload) {
+        load = calloc(nload, sizeof(*load));
+        for (i = 0; load && i < nload; i++)
+            pthread_create(&load[i], NULL, soak_load_thread, ctx);
+    }
+
+    start = last_vblank = next_deadline = now_sec();
+    while (!soak_interrupted && now_sec() - start < ctx->duration) {
+        unsigned char *frame;
+        double interval;
+
+        /*多缓冲时画到当前不显示的缓冲区;双缓冲下先等刚释放的缓冲区抓屏完成*/
+        if (ctx->nbuf > 1)
+            back = (back + 1) % ctx->nbuf;
+        if (ctx->check_capture && ctx->nbuf == 2 && ctx->have_vblank_info && ctx->frames)
+            soak_wait_capture(ctx, last_seq, ctx->period / 2);
+        frame = fb->base + (size_t)back * fb->vinfo.yres * fb->finfo.line_length;
+
+        t0 = now_sec();
+        soak_render(ctx, frame, ctx->frames);
+        t1 = now_sec();
+        hist_add(&ctx->render, t1 - t0);
+
+        if (ctx->nbuf > 1) {
+            var.yoffset = back * fb->vinfo.yres;
+            if (ioctl(fb->fd, FBIOPAN_DISPLAY, &var)) {
+                fprintf(stderr, "FBIOPAN_DISPLAY failed: %s\n", strerror(errno));
+                ret = -1;
+                break;
+            }
+        }
+        if (ctx->have_vsync) {
+            if (ioctl(fb->fd, FBIO_WAITFORVSYNC, &crtc))
+                ctx->missed++;  //等待超时说明扫描停止
+        } else {
+            struct timespec ts;
+
+            next_deadline += ctx->period;
+            ts.tv_sec = (time_t)next_deadline;
+            ts.tv_nsec = (long)((next_deadline - ts.tv_sec) * 1e9);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        }
+        t2 = now_sec();
+        hist_add(&ctx->present, t2 - t1);
+        interval = t2 - last_vblank;
+        hist_add(&ctx->interval, interval);
+        last_vblank = t2;
+
+        /*优先用驱动的vblank计数判断,每帧应正好前进1*/
+        if (ctx->have_vblank_info &&
+            ioctl(fb->fd, VDMAFB_IOCTL_GET_VBLANK, &vbi) == 0) {
+            if (ctx->frames && vbi.sequence > last_seq + 1)
+                ctx->missed += vbi.sequence - last_seq - 1;
+            last_seq = vbi.sequence;
+        } else if (ctx->frames && interval > ctx->period * 1.5) {
+            ctx->missed += (unsigned long)(interval / ctx->period + 0.5) - 1;
+        }
+        ctx->frames++;
+    }
+    t2 = now_sec();
+
+    ctx->stop = 1;
+    if (ctx->check_capture)
+        pthread_join(ctx->cap_thread, NULL);
+    for (i = 0; load && i < nload; i++)
+        pthread_join(load[i], NULL);
+    free(load);
+
+    if (ctx->nbuf > 1) {
+        var.yoffset = 0;
+        ioctl(fb->fd, FBIOPAN_DISPLAY, &var);
+    }
+
+    soak_summary(ctx, stdout, t2 - start, max_missed);
+    if (out_path) {
+        FILE *out = fopen(out_path, "w");
+
+        if (out) {
+            soak_summary(ctx, out, t2 - start, max_missed);
+            fclose(out);
+        } else {
+            printf("Error: cannot open %s\n", out_path);
+        }
+    }
+    if (ctx->missed > max_missed || ctx->cap_torn)
+        ret = -1;
+
+    pthread_cond_destroy(&ctx->cap_cond);
+    pthread_mutex_destroy(&ctx->cap_lock);
+    free(ctx->row);
+    free(ctx);
+    return ret;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [-d /dev/fbN] [demo|bench|soak [options]]\n", prog);
+}
+
+int main(int argc,char **argv)
+{
+    struct fb_dev fb;
+    const char *dev = "/dev/fb0";
+    const char *cmd = "demo";
+    int ret;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "+d:h")) != -1) {
+        switch (opt) {
+        case 'd':
+            dev = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind < argc)
+        cmd = argv[optind];
+
+    ret = fb_open(&fb, dev);
+    if (ret)
+        return 1;
+
+    if (!strcmp(cmd, "demo")) {
+        ret = run_demo(&fb);
+    } else if (!strcmp(cmd, "bench")) {
+        ret = run_bench(&fb, argc - optind, argv + optind);
+    } else if (!strcmp(cmd, "soak")) {
+        ret = run_soak(&fb, argc - optind, argv + optind);
+    } else {
+        usage(argv[0]);
+        ret = -1;
+    }
+
+    fb_close(&fb);
+    return ret ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * 分块并行渲染的测试场景
+ * 渲染逐像素计算的动态场景(等离子纹理+移动的圆),分别用1个和N个线程
+ * 各运行若干帧,输出帧率和加速比.
+ *
+ * tile_bench [-d /dev/fbN] [-n 帧数] [-j 最大线程数] [-s 块宽x块高]
+ *
+ * 编译: $(CROSS_COMPILE)gcc -O2 -mfpu=neon -o tile_bench tile_bench.c tile_render.c libvdmafb.c -lpthread -lm
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include "libvdmafb.h"
+#include "tile_render.h"
+
+struct scene {
+    struct vdmafb *fb;
+    unsigned int bpp;
+    unsigned int frame;
+    uint8_t sine[256];          /*0~255的正弦表*/
+    uint32_t palette[256];      /*已按屏幕格式打包的颜色*/
+};
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void scene_init(struct scene *sc, struct vdmafb *fb)
+{
+    unsigned int i;
+
+    sc->fb = fb;
+    sc->bpp = vdmafb_get_info(fb)->bytes_pp;
+    for (i = 0; i < 256; i++) {
+        sc->sine[i] = (uint8_t)(127.5 + 127.5 * sin(i * 2 * M_PI / 256));
+        sc->palette[i] = vdmafb_pack_color(fb, sc->sine[i], sc->sine[(i + 85) & 0xff],
+                                           sc->sine[(i + 170) & 0xff]);
+    }
+}
+
+static void put_pixel(unsigned char *p, unsigned int bpp, uint32_t c)
+{
+    switch (bpp) {
+    case 4:
+        *(uint32_t *)p = c;
+        break;
+    case 3:
+        p[0] = c;
+        p[1] = c >> 8;
+        p[2] = c >> 16;
+        break;
+    case 2:
+        *(uint16_t *)p = c;
+        break;
+    }
+}
+
+/*场景:等离子纹理,叠加一个按帧号移动的圆;每个像素的计算量相当于一般的UI合成*/
+static void scene_render(void *arg, unsigned int worker, unsigned char *tile,
+                         unsigned int stride, const struct vdmafb_rect *r)
+{
+    struct scene *sc = arg;
+    const struct vdmafb_info *info = vdmafb_get_info(sc->fb);
+    unsigned int t = sc->frame;
+    int cx = (int)(t * 5 % info->width);
+    int cy = info->height / 2;
+    int rad2 = (int)(info->height * info->height / 16);
+    int x, y;
+
+    (void)worker;
+    for (y = 0; y < r->h; y++) {
+        unsigned char *p = tile + (size_t)y * stride;
+        int sy = r->y + y;
+        uint8_t vy = sc->sine[(sy + t) & 0xff];
+
+        for (x = 0; x < r->w; x++, p += sc->bpp) {
+            int sx = r->x + x;
+            int dx = sx - cx, dy = sy - cy;
+            unsigned int v = sc->sine[(sx * 2 + t * 3) & 0xff] + vy +
+                             sc->sine[((sx + sy) + t) & 0xff];
+
+            if (dx * dx + dy * dy < rad2)
+                v = 255 - v / 3;
+            put_pixel(p, sc->bpp, sc->palette[(v / 3) & 0xff]);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *dev = "/dev/fb0";
+    unsigned int frames = 300, max_threads = 0, tw = 0, th = 0;
+    double fps1 = 0;
+    struct vdmafb *fb;
+    struct scene sc;
+    unsigned int n;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:n:j:s:")) != -1) {
+        switch (opt) {
+        case 'd':
+            dev = optarg;
+            break;
+        case 'n':
+            frames = strtoul(optarg, NULL, 0);
+            break;
+        case 'j':
+            max_threads = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            if (sscanf(optarg, "%ux%u", &tw, &th) != 2) {
+                printf("Error: bad tile size %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            printf("Usage: %s [-d /dev/fbN] [-n frames] [-j max_threads] [-s WxH]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!max_threads) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+        max_threads = ncpu > 0 ? ncpu : 1;
+    }
+
+    /*只测渲染能力,不按vsync限速*/
+    fb = vdmafb_open(dev, VDMAFB_F_SINGLE_BUFFER | VDMAFB_F_NO_VSYNC);
+    if (!fb) {
+        printf("Error: cannot open framebuffer device %s.\n", dev);
+        return 1;
+    }
+    scene_init(&sc, fb);
+
+    printf("threads,frames,seconds,fps,speedup\n");
+    for (n = 1; n <= max_threads; n++) {
+        struct tile_pool *pool = tile_pool_create(fb, n, tw, th);
+        double start, elapsed;
+        unsigned int i;
+
+        if (!pool) {
+            printf("Error: cannot create %u render threads\n", n);
+            break;
+        }
+        start = now_sec();
+        for (i = 0; i < frames; i++) {
+            void *buf = vdmafb_begin(fb);
+
+            sc.frame = i;
+            tile_pool_render(pool, buf, scene_render, &sc);
+            vdmafb_present(fb);
+        }
+        elapsed = now_sec() - start;
+        if (n == 1)
+            fps1 = frames / elapsed;
+        printf("%u,%u,%.3f,%.2f,%.2f\n", tile_pool_threads(pool), frames, elapsed,
+               frames / elapsed, frames / elapsed / fps1);
+        tile_pool_destroy(pool);
+    }
+
+    vdmafb_close(fb);
+    return 0;
+}
@@ -0,0 +1,338 @@
+/*
+ * 分块并行渲染,接口说明见tile_render.h
+ */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tile_render.h"
+
+/*
+ * 每个线程一个块队列,自己从尾部取,窃取者从头部取.
+ * 块数只有几百个,每块的渲染远长于加锁时间,用互斥锁即可
+ */
+struct tile_queue {
+    pthread_mutex_t lock;
+    unsigned int head;
+    unsigned int tail;
+    unsigned int *tiles;            /*块序号*/
+};
+
+struct tile_worker {
+    struct tile_pool *pool;
+    unsigned int id;
+    pthread_t thread;
+    unsigned char *scratch;         /*块缓冲区*/
+    struct tile_queue queue;
+};
+
+struct tile_pool {
+    struct vdmafb *fb;
+    const struct vdmafb_info *info;
+    unsigned int nthreads;
+    unsigned int tile_w, tile_h;
+    unsigned int cols, rows;
+    struct tile_worker *workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start_cond;
+    pthread_cond_t done_cond;
+    unsigned long generation;       /*每帧加1,唤醒工作线程*/
+    unsigned int active;            /*尚未完成本帧的线程数*/
+    int quit;
+
+    /*当前帧*/
+    void *buf;
+    tile_render_fn fn;
+    void *arg;
+    struct vdmafb_rect clip;
+};
+
+static void tile_pin_cpu(unsigned int cpu)
+{
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t set;
+
+    if (ncpu <= 0)
+        return;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % ncpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static int tile_queue_pop(struct tile_queue *q, unsigned int *tile)
+{
+    int ok = 0;
+
+    pthread_mutex_lock(&q->lock);
+    if (q->head < q->tail) {
+        *tile = q->tiles[--q->tail];
+        ok = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok;
+}
+
+static int tile_queue_steal(struct tile_queue *q, unsigned int *tile)
+{
+    int ok = 0;
+
+    pthread_mutex_lock(&q->lock);
+    if (q->head < q->tail) {
+        *tile = q->tiles[q->head++];
+        ok = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok;
+}
+
+static void tile_render_one(struct tile_worker *w, unsigned int tile)
+{
+    struct tile_pool *pool = w->pool;
+    unsigned int bpp = pool->info->bytes_pp;
+    unsigned int stride = pool->tile_w * bpp;
+    struct vdmafb_rect r;
+    int x1, y1;
+
+    r.x = (tile % pool->cols) * pool->tile_w;
+    r.y = (tile / pool->cols) * pool->tile_h;
+    x1 = r.x + pool->tile_w;
+    y1 = r.y + pool->tile_h;
+    if (x1 > (int)pool->info->width)
+        x1 = pool->info->width;
+    if (y1 > (int)pool->info->height)
+        y1 = pool->info->height;
+    r.w = x1 - r.x;
+    r.h = y1 - r.y;
+
+    pool->fn(pool->arg, w->id, w->scratch, stride, &r);
+    vdmafb_blit(pool->fb, pool->buf, r.x, r.y, w->scratch, stride, r.w, r.h);
+}
+
+/*处理一帧:先清空自己的队列,再依次从其它线程窃取*/
+static void tile_worker_run(struct tile_worker *w)
+{
+    struct tile_pool *pool = w->pool;
+    unsigned int tile, i;
+
+    while (tile_queue_pop(&w->queue, &tile))
+        tile_render_one(w, tile);
+    for (i = 1; i < pool->nthreads; i++) {
+        struct tile_worker *victim = &pool->workers[(w->id + i) % pool->nthreads];
+
+        while (tile_queue_steal(&victim->queue, &tile))
+            tile_render_one(w, tile);
+    }
+}
+
+static void tile_worker_finish(struct tile_pool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->active == 0)
+        pthread_cond_signal(&pool->done_cond);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void *tile_worker_thread(void *data)
+{
+    struct tile_worker *w = data;
+    struct tile_pool *pool = w->pool;
+    unsigned long seen = 0;
+
+    tile_pin_cpu(w->id);
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->quit)
+            pthread_cond_wait(&pool->start_cond, &pool->lock);
+        if (pool->quit) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        tile_worker_run(w);
+        tile_worker_finish(pool);
+    }
+    return NULL;
+}
+
+struct tile_pool *tile_pool_create(struct vdmafb *fb, unsigned int nthreads,
+                                   unsigned int tile_w, unsigned int tile_h)
+{
+    const struct vdmafb_info *info = vdmafb_get_info(fb);
+    struct tile_pool *pool;
+    unsigned int ntiles, i;
+
+    if (!nthreads) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+        nthreads = n > 0 ? n : 1;
+    }
+    pool = calloc(1, sizeof(*pool));
+    if (!pool)
+        return NULL;
+    pool->fb = fb;
+    pool->info = info;
+    pool->nthreads = nthreads;
+    pool->tile_w = tile_w ? tile_w : TILE_RENDER_DEFAULT_W;
+    pool->tile_h = tile_h ? tile_h : TILE_RENDER_DEFAULT_H;
+    pool->cols = (info->width + pool->tile_w - 1) / pool->tile_w;
+    pool->rows = (info->height + pool->tile_h - 1) / pool->tile_h;
+    ntiles = pool->cols * pool->rows;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    pool->workers = calloc(nthreads, sizeof(*pool->workers));
+    if (!pool->workers)
+        goto err;
+    for (i = 0; i < nthreads; i++) {
+        struct tile_worker *w = &pool->workers[i];
+
+        w->pool = pool;
+        w->id = i;
+        pthread_mutex_init(&w->queue.lock, NULL);
+        w->queue.tiles = malloc(sizeof(*w->queue.tiles) * ntiles);
+        /*块缓冲区按缓存行对齐*/
+        if (!w->queue.tiles ||
+            posix_memalign((void **)&w->scratch, 64, (size_t)pool->tile_w * pool->tile_h * info->bytes_pp))
+            goto err;
+    }
+
+    /*
+     * 0号线程即调用者,不改变它的CPU亲和性(库不应替应用绑核);
+     * 其余线程在此创建,各自绑定到CPU1..n-1,把CPU0留给调用者
+     */
+    for (i = 1; i < nthreads; i++) {
+        if (pthread_create(&pool->workers[i].thread, NULL, tile_worker_thread, &pool->workers[i])) {
+            pool->nthreads = i;
+            break;
+        }
+    }
+    return pool;
+
+err:
+    tile_pool_destroy(pool);
+    return NULL;
+}
+
+void tile_pool_destroy(struct tile_pool *pool)
+{
+    unsigned int i;
+
+    if (!pool)
+        return;
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->start_cond);
+    pthread_mutex_unlock(&pool->lock);
+    for (i = 0; pool->workers && i < pool->nthreads; i++) {
+        if (i && pool->workers[i].thread)
+            pthread_join(pool->workers[i].thread, NULL);
+        free(pool->workers[i].queue.tiles);
+        free(pool->workers[i].scratch);
+    }
+    free(pool->workers);
+    free(pool);
+}
+
+unsigned int tile_pool_threads(const struct tile_pool *pool)
+{
+    return pool->nthreads;
+}
+
+/*把与clip相交的块按连续区段分给各线程,相邻块在同一线程,利于预取*/
+static unsigned int tile_pool_distribute(struct tile_pool *pool)
+{
+    unsigned int c0 = pool->clip.x / pool->tile_w;
+    unsigned int r0 = pool->clip.y / pool->tile_h;
+    unsigned int c1 = (pool->clip.x + pool->clip.w + pool->tile_w - 1) / pool->tile_w;
+    unsigned int r1 = (pool->clip.y + pool->clip.h + pool->tile_h - 1) / pool->tile_h;
+    unsigned int n = (c1 - c0) * (r1 - r0);
+    unsigned int i, k = 0, per;
+
+    for (i = 0; i < pool->nthreads; i++) {
+        pool->workers[i].queue.head = 0;
+        pool->workers[i].queue.tail = 0;
+    }
+    per = (n + pool->nthreads - 1) / pool->nthreads;
+    for (i = 0; i < n; i++, k++) {
+        struct tile_queue *q = &pool->workers[k / per].queue;
+        unsigned int tile = (r0 + i / (c1 - c0)) * pool->cols + c0 + i % (c1 - c0);
+
+        /*自己从尾部取,为了按顺序渲染倒序存放*/
+        q->tiles[q->tail++] = tile;
+    }
+    for (i = 0; i < pool->nthreads; i++) {
+        struct tile_queue *q = &pool->workers[i].queue;
+        unsigned int a = q->head, b = q->tail;
+
+        while (b > a + 1) {
+            unsigned int t = q->tiles[a];
+
+            q->tiles[a++] = q->tiles[--b];
+            q->tiles[b] = t;
+        }
+    }
+    return n;
+}
+
+void tile_pool_render_rect(struct tile_pool *pool, void *buf, const struct vdmafb_rect *rect,
+                           tile_render_fn fn, void *arg)
+{
+    struct vdmafb_rect clip = *rect;
+
+    if (clip.x < 0) {
+        clip.w += clip.x;
+        clip.x = 0;
+    }
+    if (clip.y < 0) {
+        clip.h += clip.y;
+        clip.y = 0;
+    }
+    if (clip.x + clip.w > (int)pool->info->width)
+        clip.w = pool->info->width - clip.x;
+    if (clip.y + clip.h > (int)pool->info->height)
+        clip.h = pool->info->height - clip.y;
+    if (clip.w <= 0 || clip.h <= 0)
+        return;
+
+    pool->buf = buf;
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->clip = clip;
+    tile_pool_distribute(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->active = pool->nthreads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    tile_worker_run(&pool->workers[0]);
+    tile_worker_finish(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active)
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+
+    /*整块渲染,损坏区域按块边界外扩(超出屏幕的部分由vdmafb_damage裁剪)*/
+    clip.w = clip.x + clip.w;
+    clip.h = clip.y + clip.h;
+    clip.x -= clip.x % pool->tile_w;
+    clip.y -= clip.y % pool->tile_h;
+    clip.w = (clip.w + pool->tile_w - 1) / pool->tile_w * pool->tile_w - clip.x;
+    clip.h = (clip.h + pool->tile_h - 1) / pool->tile_h * pool->tile_h - clip.y;
+    vdmafb_damage(pool->fb, &clip);
+}
+
+void tile_pool_render(struct tile_pool *pool, void *buf, tile_render_fn fn, void *arg)
+{
+    struct vdmafb_rect all = { 0, 0, (int)pool->info->width, (int)pool->info->height };
+
+    tile_pool_render_rect(pool, buf, &all, fn, arg);
+}
@@ -0,0 +1,52 @@
+/*
+ * 分块并行渲染
+ *
+ * 把一帧划分为能放进L1缓存的小块,由绑定到各CPU核的工作线程并行渲染.
+ * 每个线程先在自己的块缓冲区(常驻缓存)中绘制,完成后用NEON整块写入
+ * 后台缓冲区,避免对写合并显存的零散写和读.
+ * 任务分配采用work stealing:每个线程先处理分给自己的块,做完后从其它
+ * 线程的队列头部窃取,负载不均的场景下两个核也能同时结束.
+ *
+ * 编译: $(CROSS_COMPILE)gcc -O2 -mfpu=neon -c tile_render.c
+ */
+#ifndef __TILE_RENDER_H
+#define __TILE_RENDER_H
+
+#include "libvdmafb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TILE_RENDER_DEFAULT_W   64
+#define TILE_RENDER_DEFAULT_H   64
+
+struct tile_pool;
+
+/*
+ * 渲染回调:把rect(屏幕坐标)区域画到tile中,tile的行跨度为stride字节,
+ * 像素格式与屏幕相同.worker为线程序号,可用于线程私有数据
+ */
+typedef void (*tile_render_fn)(void *arg, unsigned int worker, unsigned char *tile,
+                               unsigned int stride, const struct vdmafb_rect *rect);
+
+/*
+ * nthreads为0时使用在线CPU个数;调用tile_pool_render的线程作为0号线程参与渲染,
+ * 其CPU亲和性保持不变,需要时由应用自行绑定.tile_w/tile_h为0时使用默认值
+ */
+struct tile_pool *tile_pool_create(struct vdmafb *fb, unsigned int nthreads,
+                                   unsigned int tile_w, unsigned int tile_h);
+void tile_pool_destroy(struct tile_pool *pool);
+unsigned int tile_pool_threads(const struct tile_pool *pool);
+
+/*渲染整帧到buf(vdmafb_begin返回的缓冲区),所有块完成后返回*/
+void tile_pool_render(struct tile_pool *pool, void *buf, tile_render_fn fn, void *arg);
+/*同上,只渲染与区域相交的块,并记录为损坏区域*/
+void tile_pool_render_rect(struct tile_pool *pool, void *buf, const struct vdmafb_rect *rect,
+                           tile_render_fn fn, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
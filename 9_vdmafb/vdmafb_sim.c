@@ -0,0 +1,585 @@
+/*
+ * xlnx_vdmafb仿真后端
+ * 提供一个虚拟的dmaengine控制器和假的VTC,使xlnx_vdmafb可以在没有Zynq硬件的
+ * 内核(QEMU、x86)上加载,用于测试翻页、vblank、抓屏等功能的性能
+ *
+ * "lcd_vdma"通道: 按刷新率用hrtimer"扫描"交错传输,每帧取走一个已提交的描述符并完成它,
+ *                 没有新描述符时继续扫描上一帧,与VDMA的park模式一致
+ * "capture"通道:  memcpy在tasklet中由CPU完成
+ * 假VTC:          实现xvtc_of_get/xvtc_generator_start等接口,启动时开始按帧率扫描
+ * 内存登记:       xlnx_vdmafb登记显存和抓屏缓冲区的CPU地址,仿真通道按dma地址查找
+ *
+ * 使用: make SIM=1, 先加载vdmafb_sim.ko, 再加载xlnx_vdmafb.ko
+ */
+#include <linux/module.h>
+#include <linux/platform_device.h>
+#include <linux/property.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
+#include <linux/hrtimer.h>
+#include <linux/interrupt.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/debugfs.h>
+#include <linux/mm.h>
+#include <linux/io.h>
+#include <linux/version.h>
+#include <video/videomode.h>
+#include "sim/xilinx-vtc.h"
+#include "sim/vdmafb_sim.h"
+
+static unsigned int width = 1280;
+module_param(width, uint, 0444);
+MODULE_PARM_DESC(width, "Simulated panel width");
+
+static unsigned int height = 800;
+module_param(height, uint, 0444);
+MODULE_PARM_DESC(height, "Simulated panel height");
+
+static unsigned int refresh_hz;
+module_param(refresh_hz, uint, 0444);
+MODULE_PARM_DESC(refresh_hz, "Scanout refresh rate, 0 = use the VTC config");
+
+static unsigned int num_buffers = 2;
+module_param(num_buffers, uint, 0444);
+MODULE_PARM_DESC(num_buffers, "xlnx,num-buffers passed to the framebuffer");
+
+static bool record;
+module_param(record, bool, 0444);
+MODULE_PARM_DESC(record, "Keep a copy of the last scanned frame in debugfs");
+
+struct vdmafb_sim_desc {
+    struct dma_async_tx_descriptor txd;
+    struct list_head node;
+    dma_addr_t src;
+    dma_addr_t dst;                 /*memcpy目的地址*/
+    size_t len;                     /*memcpy长度或一帧的字节数*/
+};
+
+struct vdmafb_sim_chan {
+    struct dma_chan chan;
+    struct list_head pending;       /*已submit,未issue*/
+    struct list_head queued;        /*已issue,等待扫描或执行*/
+    struct list_head done;          /*已完成,等待回调*/
+};
+
+/*已登记的内存区域,dma地址到CPU地址*/
+struct vdmafb_sim_region {
+    struct list_head node;
+    dma_addr_t dma;
+    void *virt;
+    size_t len;
+};
+
+/*假VTC*/
+struct xvtc_device {
+    struct xvtc_config config;
+};
+
+struct vdmafb_sim {
+    struct platform_device *pdev;       /*虚拟dma控制器*/
+    struct platform_device *fb_pdev;    /*交给xlnx_vdmafb的设备*/
+    struct dma_device dma;
+    struct vdmafb_sim_chan vdma;
+    struct vdmafb_sim_chan memcpy;
+    struct dma_slave_map slave_map[2];
+    struct xvtc_device vtc;
+
+    spinlock_t lock;                /*保护描述符队列、扫描状态和regions*/
+    struct list_head regions;
+    struct tasklet_struct tasklet;
+    struct hrtimer timer;
+    ktime_t period;
+    bool scanning;
+    dma_addr_t scan_addr;           /*当前扫描的帧*/
+    size_t frame_size;
+    u64 frames;                     /*扫描的帧数*/
+    u64 flips;                      /*完成的描述符数*/
+
+    void *record_buf;
+    struct debugfs_blob_wrapper blob;
+    struct dentry *debugfs;
+};
+
+static struct vdmafb_sim *sim;
+
+static struct vdmafb_sim_chan *to_sim_chan(struct dma_chan *chan)
+{
+    return container_of(chan, struct vdmafb_sim_chan, chan);
+}
+
+void vdmafb_sim_add_region(dma_addr_t dma, void *virt, size_t len)
+{
+    struct vdmafb_sim_region *r;
+    unsigned long flags;
+
+    r = kzalloc(sizeof(*r), GFP_KERNEL);
+    if (!r) {
+        pr_warn("vdmafb_sim: no memory to register %pad\n", &dma);
+        return;
+    }
+    r->dma = dma;
+    r->virt = virt;
+    r->len = len;
+
+    spin_lock_irqsave(&sim->lock, flags);
+    list_add_tail(&r->node, &sim->regions);
+    spin_unlock_irqrestore(&sim->lock, flags);
+}
+EXPORT_SYMBOL_GPL(vdmafb_sim_add_region);
+
+void vdmafb_sim_del_region(dma_addr_t dma)
+{
+    struct vdmafb_sim_region *r, *found = NULL;
+    unsigned long flags;
+
+    spin_lock_irqsave(&sim->lock, flags);
+    list_for_each_entry(r, &sim->regions, node) {
+        if (r->dma == dma) {
+            list_del(&r->node);
+            found = r;
+            break;
+        }
+    }
+    spin_unlock_irqrestore(&sim->lock, flags);
+    kfree(found);
+}
+EXPORT_SYMBOL_GPL(vdmafb_sim_del_region);
+
+/*
+ * dma地址转换为登记时的CPU地址,[addr, addr + len)须落在同一区域内
+ * 不假设dma地址等于物理地址(IOMMU、swiotlb下不成立)
+ */
+static void *vdmafb_sim_virt(dma_addr_t addr, size_t len)
+{
+    struct vdmafb_sim_region *r;
+    void *virt = NULL;
+    unsigned long flags;
+
+    spin_lock_irqsave(&sim->lock, flags);
+    list_for_each_entry(r, &sim->regions, node) {
+        if (addr >= r->dma && len <= r->len && addr - r->dma <= r->len - len) {
+            virt = r->virt + (addr - r->dma);
+            break;
+        }
+    }
+    spin_unlock_irqrestore(&sim->lock, flags);
+    return virt;
+}
+
+static void vdmafb_sim_complete(struct vdmafb_sim_desc *d)
+{
+    struct dma_async_tx_descriptor *txd = &d->txd;
+    struct dmaengine_result res = { .result = DMA_TRANS_NOERROR };
+
+    txd->chan->completed_cookie = txd->cookie;
+    if (txd->callback_result)
+        txd->callback_result(txd->callback_param, &res);
+    else if (txd->callback)
+        txd->callback(txd->callback_param);
+    kfree(d);
+}
+
+/*tasklet: 执行memcpy,回调已完成的描述符,记录扫描的帧*/
+static void vdmafb_sim_tasklet_fn(unsigned long data)
+{
+    struct vdmafb_sim_desc *d, *tmp;
+    void *src, *dst;
+    dma_addr_t scan_addr;
+    size_t frame_size;
+    unsigned long flags;
+    LIST_HEAD(copies);
+    LIST_HEAD(done);
+
+    spin_lock_irqsave(&sim->lock, flags);
+    list_splice_tail_init(&sim->memcpy.queued, &copies);
+    list_splice_tail_init(&sim->vdma.done, &done);
+    scan_addr = sim->scan_addr;
+    frame_size = sim->frame_size;
+    spin_unlock_irqrestore(&sim->lock, flags);
+
+    list_for_each_entry_safe(d, tmp, &copies, node) {
+        src = vdmafb_sim_virt(d->src, d->len);
+        dst = vdmafb_sim_virt(d->dst, d->len);
+        if (src && dst)
+            memcpy(dst, src, d->len);
+        else
+            pr_warn_ratelimited("vdmafb_sim: memcpy to unregistered memory %pad\n", &d->dst);
+        list_del(&d->node);
+        vdmafb_sim_complete(d);
+    }
+
+    if (!list_empty(&done) && sim->record_buf && scan_addr) {
+        src = vdmafb_sim_virt(scan_addr, min_t(size_t, frame_size, sim->blob.size));
+        if (src)
+            memcpy(sim->record_buf, src, min_t(size_t, frame_size, sim->blob.size));
+    }
+
+    list_for_each_entry_safe(d, tmp, &done, node) {
+        list_del(&d->node);
+        vdmafb_sim_complete(d);
+    }
+}
+
+/*每个刷新周期扫描一帧,取走下一个描述符作为扫描地址*/
+static enum hrtimer_restart vdmafb_sim_timer_fn(struct hrtimer *timer)
+{
+    struct vdmafb_sim_desc *d;
+    unsigned long flags;
+
+    spin_lock_irqsave(&sim->lock, flags);
+    if (!sim->scanning) {
+        spin_unlock_irqrestore(&sim->lock, flags);
+        return HRTIMER_NORESTART;
+    }
+    sim->frames++;
+    d = list_first_entry_or_null(&sim->vdma.queued, struct vdmafb_sim_desc, node);
+    if (d) {
+        sim->scan_addr = d->src;
+        sim->frame_size = d->len;
+        sim->flips++;
+        list_move_tail(&d->node, &sim->vdma.done);
+    }
+    spin_unlock_irqrestore(&sim->lock, flags);
+
+    if (d)
+        tasklet_schedule(&sim->tasklet);
+
+    hrtimer_forward_now(timer, sim->period);
+    return HRTIMER_RESTART;
+}
+
+static dma_cookie_t vdmafb_sim_tx_submit(struct dma_async_tx_descriptor *txd)
+{
+    struct vdmafb_sim_desc *d = container_of(txd, struct vdmafb_sim_desc, txd);
+    struct vdmafb_sim_chan *sc = to_sim_chan(txd->chan);
+    dma_cookie_t cookie;
+    unsigned long flags;
+
+    spin_lock_irqsave(&sim->lock, flags);
+    cookie = txd->chan->cookie + 1;
+    if (cookie < DMA_MIN_COOKIE)
+        cookie = DMA_MIN_COOKIE;
+    txd->chan->cookie = cookie;
+    txd->cookie = cookie;
+    list_add_tail(&d->node, &sc->pending);
+    spin_unlock_irqrestore(&sim->lock, flags);
+
+    return cookie;
+}
+
+static struct vdmafb_sim_desc *vdmafb_sim_desc_alloc(struct dma_chan *chan, unsigned long flags)
+{
+    struct vdmafb_sim_desc *d;
+
+    d = kzalloc(sizeof(*d), GFP_NOWAIT);
+    if (!d)
+        return NULL;
+    dma_async_tx_descriptor_init(&d->txd, chan);
+    d->txd.flags = flags;
+    d->txd.tx_submit = vdmafb_sim_tx_submit;
+    return d;
+}
+
+static struct dma_async_tx_descriptor *
+vdmafb_sim_prep_interleaved(struct dma_chan *chan, struct dma_interleaved_template *xt,
+                            unsigned long flags)
+{
+    struct vdmafb_sim_desc *d;
+
+    if (chan != &sim->vdma.chan || xt->dir != DMA_MEM_TO_DEV || xt->frame_size != 1)
+        return NULL;
+
+    d = vdmafb_sim_desc_alloc(chan, flags);
+    if (!d)
+        return NULL;
+    d->src = xt->src_start;
+    d->len = xt->numf * (xt->sgl[0].size + xt->sgl[0].icg);
+    return &d->txd;
+}
+
+static struct dma_async_tx_descriptor *
+vdmafb_sim_prep_memcpy(struct dma_chan *chan, dma_addr_t dst, dma_addr_t src,
+                       size_t len, unsigned long flags)
+{
+    struct vdmafb_sim_desc *d;
+
+    if (chan != &sim->memcpy.chan)
+        return NULL;
+
+    d = vdmafb_sim_desc_alloc(chan, flags);
+    if (!d)
+        return NULL;
+    d->src = src;
+    d->dst = dst;
+    d->len = len;
+    return &d->txd;
+}
+
+static void vdmafb_sim_issue_pending(struct dma_chan *chan)
+{
+    struct vdmafb_sim_chan *sc = to_sim_chan(chan);
+    unsigned long flags;
+
+    spin_lock_irqsave(&sim->lock, flags);
+    list_splice_tail_init(&sc->pending, &sc->queued);
+    spin_unlock_irqrestore(&sim->lock, flags);
+
+    /*memcpy立即执行,扫描通道等待下一帧*/
+    if (sc == &sim->memcpy)
+        tasklet_schedule(&sim->tasklet);
+}
+
+static int vdmafb_sim_terminate_all(struct dma_chan *chan)
+{
+    struct vdmafb_sim_chan *sc = to_sim_chan(chan);
+    struct vdmafb_sim_desc *d, *tmp;
+    unsigned long flags;
+    LIST_HEAD(head);
+
+    spin_lock_irqsave(&sim->lock, flags);
+    list_splice_tail_init(&sc->pending, &head);
+    list_splice_tail_init(&sc->queued, &head);
+    list_splice_tail_init(&sc->done, &head);
+    spin_unlock_irqrestore(&sim->lock, flags);
+
+    list_for_each_entry_safe(d, tmp, &head, node)
+        kfree(d);
+    return 0;
+}
+
+static void vdmafb_sim_synchronize(struct dma_chan *chan)
+{
+    tasklet_kill(&sim->tasklet);
+}
+
+static enum dma_status vdmafb_sim_tx_status(struct dma_chan *chan, dma_cookie_t cookie,
+                                            struct dma_tx_state *state)
+{
+    dma_cookie_t last = READ_ONCE(chan->cookie);
+    dma_cookie_t complete = READ_ONCE(chan->completed_cookie);
+
+    dma_set_tx_state(state, complete, last, 0);
+    return dma_async_is_complete(cookie, complete, last);
+}
+
+static int vdmafb_sim_alloc_chan_resources(struct dma_chan *chan)
+{
+    return 0;
+}
+
+static void vdmafb_sim_free_chan_resources(struct dma_chan *chan)
+{
+    vdmafb_sim_terminate_all(chan);
+}
+
+static bool vdmafb_sim_filter(struct dma_chan *chan, void *param)
+{
+    return chan == param;
+}
+
+static void vdmafb_sim_init_chan(struct vdmafb_sim_chan *sc)
+{
+    INIT_LIST_HEAD(&sc->pending);
+    INIT_LIST_HEAD(&sc->queued);
+    INIT_LIST_HEAD(&sc->done);
+    sc->chan.device = &sim->dma;
+    sc->chan.cookie = DMA_MIN_COOKIE;
+    sc->chan.completed_cookie = DMA_MIN_COOKIE;
+    list_add_tail(&sc->chan.device_node, &sim->dma.channels);
+}
+
+static int vdmafb_sim_register_dma(void)
+{
+    struct dma_device *dma = &sim->dma;
+
+    INIT_LIST_HEAD(&dma->channels);
+    dma_cap_set(DMA_SLAVE, dma->cap_mask);
+    dma_cap_set(DMA_PRIVATE, dma->cap_mask);
+    dma_cap_set(DMA_INTERLEAVE, dma->cap_mask);
+    dma_cap_set(DMA_MEMCPY, dma->cap_mask);
+
+    dma->dev = &sim->pdev->dev;
+    dma->directions = BIT(DMA_MEM_TO_DEV) | BIT(DMA_MEM_TO_MEM);
+    dma->residue_granularity = DMA_RESIDUE_GRANULARITY_DESCRIPTOR;
+    dma->device_alloc_chan_resources = vdmafb_sim_alloc_chan_resources;
+    dma->device_free_chan_resources = vdmafb_sim_free_chan_resources;
+    dma->device_prep_interleaved_dma = vdmafb_sim_prep_interleaved;
+    dma->device_prep_dma_memcpy = vdmafb_sim_prep_memcpy;
+    dma->device_issue_pending = vdmafb_sim_issue_pending;
+    dma->device_terminate_all = vdmafb_sim_terminate_all;
+    dma->device_synchronize = vdmafb_sim_synchronize;
+    dma->device_tx_status = vdmafb_sim_tx_status;
+
+    vdmafb_sim_init_chan(&sim->vdma);
+    vdmafb_sim_init_chan(&sim->memcpy);
+
+    /*xlnx_vdmafb经dma_request_chan()按设备名和通道名找到这两个通道*/
+    sim->slave_map[0].devname = "xilinx-vdmafb";
+    sim->slave_map[0].slave = "lcd_vdma";
+    sim->slave_map[0].param = &sim->vdma.chan;
+    sim->slave_map[1].devname = "xilinx-vdmafb";
+    sim->slave_map[1].slave = "capture";
+    sim->slave_map[1].param = &sim->memcpy.chan;
+    dma->filter.map = sim->slave_map;
+    dma->filter.mapcnt = ARRAY_SIZE(sim->slave_map);
+    dma->filter.fn = vdmafb_sim_filter;
+
+    return dma_async_device_register(dma);
+}
+
+/*假VTC,xlnx_vdmafb以SIM=1编译时链接到这里*/
+struct xvtc_device *xvtc_of_get(struct device_node *np)
+{
+    return &sim->vtc;
+}
+EXPORT_SYMBOL_GPL(xvtc_of_get);
+
+void xvtc_put(struct xvtc_device *xvtc)
+{
+}
+EXPORT_SYMBOL_GPL(xvtc_put);
+
+int xvtc_generator_start(struct xvtc_device *xvtc, const struct xvtc_config *config)
+{
+    unsigned int fps = refresh_hz ? refresh_hz : config->fps;
+
+    xvtc->config = *config;
+    sim->period = ns_to_ktime(NSEC_PER_SEC / (fps ? fps : 60));
+    sim->scanning = true;
+    hrtimer_start(&sim->timer, sim->period, HRTIMER_MODE_REL);
+    return 0;
+}
+EXPORT_SYMBOL_GPL(xvtc_generator_start);
+
+int xvtc_generator_stop(struct xvtc_device *xvtc)
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&sim->lock, flags);
+    sim->scanning = false;
+    spin_unlock_irqrestore(&sim->lock, flags);
+    hrtimer_cancel(&sim->timer);
+    return 0;
+}
+EXPORT_SYMBOL_GPL(xvtc_generator_stop);
+
+/*注册交给xlnx_vdmafb的设备,时序按CVT-RB近似,像素时钟由刷新率反推*/
+static int vdmafb_sim_register_fb(void)
+{
+    struct property_entry props[] = {
+        PROPERTY_ENTRY_U32("xlnx,num-buffers", num_buffers),
+        { }
+    };
+    struct platform_device_info info = {
+        .name = "xilinx-vdmafb",
+        .id = PLATFORM_DEVID_NONE,
+        .properties = props,
+        .dma_mask = DMA_BIT_MASK(32),
+    };
+    struct videomode vm = {
+        .hactive = width,
+        .hfront_porch = 48,
+        .hsync_len = 32,
+        .hback_porch = 80,
+        .vactive = height,
+        .vfront_porch = 3,
+        .vsync_len = 6,
+        .vback_porch = 14,
+    };
+
+    vm.pixelclock = (unsigned long)(width + 160) * (height + 23) *
+                    (refresh_hz ? refresh_hz : 60);
+    info.data = &vm;
+    info.size_data = sizeof(vm);
+
+    sim->fb_pdev = platform_device_register_full(&info);
+    return PTR_ERR_OR_ZERO(sim->fb_pdev);
+}
+
+static int __init vdmafb_sim_init(void)
+{
+    struct platform_device_info info = {
+        .name = "vdmafb-sim",
+        .id = PLATFORM_DEVID_NONE,
+        .dma_mask = DMA_BIT_MASK(32),
+    };
+    int ret;
+
+    sim = kzalloc(sizeof(*sim), GFP_KERNEL);
+    if (!sim)
+        return -ENOMEM;
+
+    spin_lock_init(&sim->lock);
+    INIT_LIST_HEAD(&sim->regions);
+    tasklet_init(&sim->tasklet, vdmafb_sim_tasklet_fn, 0);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+    hrtimer_setup(&sim->timer, vdmafb_sim_timer_fn, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+#else
+    hrtimer_init(&sim->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+    sim->timer.function = vdmafb_sim_timer_fn;
+#endif
+
+    sim->pdev = platform_device_register_full(&info);
+    if (IS_ERR(sim->pdev)) {
+        ret = PTR_ERR(sim->pdev);
+        goto out1;
+    }
+
+    ret = vdmafb_sim_register_dma();
+    if (ret) {
+        pr_err("vdmafb_sim: failed to register dma device\n");
+        goto out2;
+    }
+
+    sim->debugfs = debugfs_create_dir("vdmafb_sim", NULL);
+    debugfs_create_u64("frames", 0444, sim->debugfs, &sim->frames);
+    debugfs_create_u64("flips", 0444, sim->debugfs, &sim->flips);
+    if (record) {
+        sim->blob.size = (unsigned long)width * height * 3;
+        sim->record_buf = vzalloc(sim->blob.size);
+        if (sim->record_buf) {
+            sim->blob.data = sim->record_buf;
+            debugfs_create_blob("last_frame", 0444, sim->debugfs, &sim->blob);
+        }
+    }
+
+    ret = vdmafb_sim_register_fb();
+    if (ret) {
+        pr_err("vdmafb_sim: failed to register framebuffer device\n");
+        goto out3;
+    }
+
+    pr_info("vdmafb_sim: %ux%u, %u buffers, refresh %u Hz\n",
+            width, height, num_buffers, refresh_hz ? refresh_hz : 60);
+    return 0;
+
+out3:
+    debugfs_remove_recursive(sim->debugfs);
+    vfree(sim->record_buf);
+    dma_async_device_unregister(&sim->dma);
+out2:
+    platform_device_unregister(sim->pdev);
+out1:
+    kfree(sim);
+    return ret;
+}
+
+static void __exit vdmafb_sim_exit(void)
+{
+    platform_device_unregister(sim->fb_pdev);
+    xvtc_generator_stop(&sim->vtc);
+    tasklet_kill(&sim->tasklet);
+    debugfs_remove_recursive(sim->debugfs);
+    dma_async_device_unregister(&sim->dma);
+    platform_device_unregister(sim->pdev);
+    vfree(sim->record_buf);
+    kfree(sim);
+}
+
+module_init(vdmafb_sim_init);
+module_exit(vdmafb_sim_exit);
+
+MODULE_AUTHOR("LVD");
+MODULE_DESCRIPTION("Simulated VTC/VDMA backend for xlnx_vdmafb");
+MODULE_LICENSE("GPL");
@@ -7,18 +7,145 @@
 #include <linux/of_dma.h>
 #include <video/videomode.h>
 #include <linux/delay.h>
-#include <linux/of_gpio.h>
-#include <linux/gpio/consumer.h>
 #include <video/of_videomode.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+#include <linux/uaccess.h>
+#include <linux/mm.h>
+#include <linux/huge_mm.h>
+#include <linux/of_reserved_mem.h>
+#include <linux/io.h>
+#include <linux/vmalloc.h>
+#include <linux/mutex.h>
+#include <linux/bitmap.h>
+#include <linux/crc32.h>
+#include <linux/workqueue.h>
+#include <linux/console.h>
+#include <linux/pm.h>
+#include <linux/property.h>
+#include <linux/version.h>
 #include "linux/device.h"
-#include "linux/gpio.h"
 #include "xilinx-vtc.h"
+#include "xlnx_vdmafb.h"
+
+/*
+ * SIM=1时以本机较新的内核编译,只用在各版本都可用的接口;
+ * LCD ID引脚(旧式GPIO接口)和PMD大页mmap只在实际的目标内核上编译
+ */
+#ifdef VDMAFB_SIM
+#include "vdmafb_sim.h"
+#else
+#include <linux/of_gpio.h>
+#include <linux/gpio/consumer.h>
+#include "linux/gpio.h"
+
+/*仿真后端由CPU访问显存和抓屏缓冲区,需登记其CPU地址;实际硬件上为空操作*/
+static inline void vdmafb_sim_add_region(dma_addr_t dma, void *virt, size_t len)
+{
+}
+
+static inline void vdmafb_sim_del_region(dma_addr_t dma)
+{
+}
+#endif
+
+#if defined(CONFIG_TRANSPARENT_HUGEPAGE) && !defined(VDMAFB_SIM)
+#define VDMAFB_HUGE_MMAP
+#include <linux/pfn_t.h>
+#endif
+
+/*6.3起vma->vm_flags只读,须经vm_flags_set/clear修改*/
+static inline void vdmafb_vm_flags_set(struct vm_area_struct *vma, vm_flags_t flags)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+    vm_flags_set(vma, flags);
+#else
+    vma->vm_flags |= flags;
+#endif
+}
+
+static inline void vdmafb_vm_flags_clear(struct vm_area_struct *vma, vm_flags_t flags)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+    vm_flags_clear(vma, flags);
+#else
+    vma->vm_flags &= ~flags;
+#endif
+}
 
 
 
 /*LCD屏硬件ID*/
 #define ATK1018 5      //10寸 1280*800
 
+#define VDMAFB_MAX_BUFFERS          4       //最多支持的显存缓冲区个数
+#define VDMAFB_DEFAULT_MARGIN_US    500     //迟锁存默认提前量
+#define VDMAFB_MAX_QUEUED           4       //已提交未完成的VDMA描述符上限
+
+/*
+ * 显存分配对齐.只有支持THP的内核(arm64、ARM LPAE)的mmap能以PMD大页映射显存,
+ * 此时按大页对齐;Cortex-A9等非LPAE内核用户页表只有4KB小页,按页对齐即可,
+ * 不为对齐多占CMA
+ */
+#ifdef VDMAFB_HUGE_MMAP
+#define VDMAFB_MEM_ALIGN            HPAGE_PMD_SIZE
+#else
+#define VDMAFB_MEM_ALIGN            PAGE_SIZE
+#endif
+
+
+/*抓屏缓冲区按物理连续块分配,每块一个memcpy描述符*/
+#define VDMAFB_CAPTURE_CHUNK_ORDER  6
+#define VDMAFB_CAPTURE_CHUNK_SIZE   (PAGE_SIZE << VDMAFB_CAPTURE_CHUNK_ORDER)
+
+/*抓屏缓冲区状态*/
+enum vdmafb_capture_state {
+    VDMAFB_CAP_FREE,        /*空闲,可用于抓取*/
+    VDMAFB_CAP_BUSY,        /*DMA拷贝中*/
+    VDMAFB_CAP_DONE,        /*已抓取,等待用户取走*/
+    VDMAFB_CAP_USER,        /*用户持有*/
+};
+
+struct vdmafb_capture_buffer {
+    struct page **chunks;               /*每个物理连续块的首页*/
+    dma_addr_t *chunk_dma;              /*每个块的DMA地址*/
+    int state;
+    struct vdmafb_capture_buf info;     /*抓取的序号、时间戳等*/
+};
+
+/*抓屏:在vblank时用dmaengine memcpy把前台缓冲区拷贝到可缓存的环形缓冲区*/
+struct vdmafb_capture {
+    struct mutex mutex;                 /*保护缓冲区分配/释放与mmap*/
+    spinlock_t lock;                    /*保护缓冲区状态*/
+    wait_queue_head_t wait;
+    struct dma_chan *chan;              /*memcpy DMA通道*/
+    struct vdmafb_capture_buffer bufs[VDMAFB_CAPTURE_MAX_BUFS];
+    unsigned int count;                 /*缓冲区个数,0表示未分配*/
+    unsigned int nchunks;               /*每个缓冲区的块数*/
+    size_t buf_size;                    /*每个缓冲区的mmap大小*/
+    bool active;                        /*是否在vblank时触发抓取*/
+    bool busy;                          /*是否有拷贝在进行*/
+    bool suspended_active;              /*休眠前是否在抓取,唤醒后恢复*/
+    u32 mode;
+    u32 interval;
+    u32 countdown;                      /*距下一次抓取的帧数*/
+    u64 sequence;
+    u64 done;                           /*已结束(完成或失败)的拷贝次数,DQBUF据此等待*/
+};
+
+/*逐行CRC帧完整性校验*/
+struct vdmafb_crc {
+    bool enabled;
+    spinlock_t lock;                    /*保护dirty与info*/
+    struct work_struct work;            /*vblank后计算损坏行*/
+    u32 nlines;                         /*yres_virtual*/
+    u32 *line_crc;                      /*每行的CRC32*/
+    unsigned long *dirty;               /*待重新计算的行*/
+    unsigned long *snapshot;            /*工作函数中取走的dirty*/
+    struct vdmafb_crc_info info;        /*最近一次的帧签名*/
+};
 
 /*自定义结构体用于描述我们的LCD设备*/
 struct xilinx_vdmafb_dev
@@ -28,6 +155,44 @@ struct xilinx_vdmafb_dev
     struct clk *pclk;               /*像素时钟*/
     struct xvtc_device *vtc;         /*vtc设备*/
     struct dma_chan *vdma;          /*VDMA通道*/
+    struct dma_interleaved_template *dma_template;  /*VDMA描述符模板*/
+    struct xilinx_vdma_config vdma_config;          /*VDMA通道配置,休眠唤醒后恢复*/
+    struct xvtc_config vtc_config;                  /*VTC时序配置,休眠唤醒后恢复*/
+
+    unsigned int num_buffers;       /*显存缓冲区个数,yres_virtual = yres * num_buffers*/
+    unsigned int buf_size;          /*单个缓冲区大小*/
+    size_t mem_size;                /*实际分配的显存大小,按VDMAFB_MEM_ALIGN对齐*/
+    int mem_type;                   /*显存后端,VDMAFB_MEM_xxx*/
+    phys_addr_t mem_phys;           /*显存物理地址*/
+    void *mem_virt;                 /*显存内核映射,按需建立,可能为NULL*/
+    void *mem_cookie;               /*DMA_ATTR_NO_KERNEL_MAPPING分配返回的cookie*/
+    struct mutex kmap_lock;         /*保护按需建立内核映射*/
+
+    bool blanked;                   /*fb_blank关闭了显示输出,受fb_info锁保护*/
+
+    spinlock_t lock;                /*保护以下显示状态及描述符模板的使用*/
+    bool running;                   /*VDMA是否在持续提交帧*/
+    dma_addr_t front_addr;          /*最近提交(锁存)的缓冲区*/
+    dma_addr_t pending_addr;        /*pan后等待提交的缓冲区,0表示无*/
+    dma_addr_t queued_addr[VDMAFB_MAX_QUEUED];  /*已提交未完成的描述符对应的缓冲区,按提交顺序*/
+    unsigned int queued_head;
+    unsigned int queued;            /*已提交未完成的描述符个数*/
+
+    /*vblank跟踪,以VDMA帧完成回调作为帧边界*/
+    wait_queue_head_t vblank_wait;
+    u64 vblank_count;               /*已完成帧计数*/
+    dma_addr_t scanned_addr;        /*最近一次完成扫描的缓冲区,帧校验按它取签名*/
+    ktime_t vblank_time;            /*最近一次帧完成时间*/
+    ktime_t next_vblank;            /*预测的下一次帧完成时间*/
+    u64 frame_period_ns;            /*预测的帧周期*/
+
+    /*迟锁存提交*/
+    u32 present_mode;               /*VDMAFB_PRESENT_xxx*/
+    u32 latch_margin_us;            /*提前于预测vblank的时间*/
+    struct hrtimer latch_timer;
+
+    struct vdmafb_capture cap;      /*抓屏*/
+    struct vdmafb_crc crc;          /*帧完整性校验*/
 };
 
 
@@ -105,18 +270,1277 @@ static int vdmafb_check_var(struct fb_var_screeninfo *var,struct fb_info *info)
     return 0;
 }
 
+/*
+ * 显存后端
+ * VDMAFB_MEM_WC:       dma_alloc_wc()分配,内核始终有写合并映射(默认)
+ * VDMAFB_MEM_NOKMAP:   DMA_ATTR_NO_KERNEL_MAPPING分配,不占用vmalloc空间
+ * VDMAFB_MEM_RESERVED: 设备树memory-region指定的no-map保留内存,不占用CMA
+ * 后两种模式下内核映射只在fbcon、read/write等需要时才建立
+ */
+enum vdmafb_mem_type {
+    VDMAFB_MEM_WC,
+    VDMAFB_MEM_NOKMAP,
+    VDMAFB_MEM_RESERVED,
+};
+
+static int vdmafb_alloc_mem(struct xilinx_vdmafb_dev *fbdev, size_t size)
+{
+    struct device *dev = &fbdev->pdev->dev;
+    struct device_node *np;
+    struct reserved_mem *rmem;
+    void *vaddr;
+
+    np = of_parse_phandle(dev->of_node, "memory-region", 0);
+    if (np) {
+        rmem = of_reserved_mem_lookup(np);
+        of_node_put(np);
+        if (!rmem) {
+            dev_err(dev, "Failed to lookup memory-region\n");
+            return -ENODEV;
+        }
+        if (rmem->size < size) {
+            dev_err(dev, "memory-region too small: %pa < 0x%zx\n", &rmem->size, size);
+            return -ENOMEM;
+        }
+        fbdev->mem_type = VDMAFB_MEM_RESERVED;
+        fbdev->mem_phys = rmem->base;
+        fbdev->mem_virt = NULL;
+        fbdev->mem_size = size;
+
+        /*保留内存没有被清零,临时映射清屏*/
+        vaddr = memremap(fbdev->mem_phys, size, MEMREMAP_WC);
+        if (!vaddr)
+            return -ENOMEM;
+        memset(vaddr, 0, size);
+        memunmap(vaddr);
+        return 0;
+    }
+
+    if (device_property_read_bool(dev, "xlnx,no-kernel-mapping")) {
+        /*返回值只是一个cookie,不能用来访问显存;分配时已清零*/
+        fbdev->mem_cookie = dma_alloc_attrs(dev, size, &fbdev->mem_phys, GFP_KERNEL,
+                                            DMA_ATTR_WRITE_COMBINE | DMA_ATTR_NO_KERNEL_MAPPING);
+        if (!fbdev->mem_cookie)
+            return -ENOMEM;
+        fbdev->mem_type = VDMAFB_MEM_NOKMAP;
+        fbdev->mem_virt = NULL;
+        fbdev->mem_size = size;
+        return 0;
+    }
+
+    vaddr = dma_alloc_wc(dev, size, &fbdev->mem_phys, GFP_KERNEL);
+    if (!vaddr)
+        return -ENOMEM;
+    memset(vaddr, 0, size);
+    vdmafb_sim_add_region(fbdev->mem_phys, vaddr, size);
+    fbdev->mem_type = VDMAFB_MEM_WC;
+    fbdev->mem_virt = vaddr;
+    fbdev->mem_size = size;
+    return 0;
+}
+
+/*按需建立显存的内核映射*/
+static int vdmafb_kmap(struct xilinx_vdmafb_dev *fbdev)
+{
+    struct fb_info *info = fbdev->fb_info;
+    unsigned int i, npages = fbdev->mem_size >> PAGE_SHIFT;
+    struct page **pages;
+    void *vaddr = NULL;
+
+    mutex_lock(&fbdev->kmap_lock);
+    if (fbdev->mem_virt)
+        goto out;
+
+    if (fbdev->mem_type == VDMAFB_MEM_RESERVED) {
+        vaddr = memremap(fbdev->mem_phys, fbdev->mem_size, MEMREMAP_WC);
+    } else {
+        pages = kmalloc_array(npages, sizeof(*pages), GFP_KERNEL);
+        if (pages) {
+            for (i = 0; i < npages; i++)
+                pages[i] = pfn_to_page(PHYS_PFN(fbdev->mem_phys) + i);
+            vaddr = vmap(pages, npages, VM_MAP, pgprot_writecombine(PAGE_KERNEL));
+            kfree(pages);
+        }
+    }
+    if (!vaddr) {
+        mutex_unlock(&fbdev->kmap_lock);
+        dev_err(&fbdev->pdev->dev, "Failed to map framebuffer\n");
+        return -ENOMEM;
+    }
+
+    fbdev->mem_virt = vaddr;
+    info->screen_base = vaddr;
+    dev_info(&fbdev->pdev->dev, "Frame Buffer kernel mapping created\n");
+out:
+    mutex_unlock(&fbdev->kmap_lock);
+    return 0;
+}
+
+static void vdmafb_free_mem(struct xilinx_vdmafb_dev *fbdev)
+{
+    struct device *dev = &fbdev->pdev->dev;
+
+    switch (fbdev->mem_type) {
+    case VDMAFB_MEM_WC:
+        vdmafb_sim_del_region(fbdev->mem_phys);
+        dma_free_wc(dev, fbdev->mem_size, fbdev->mem_virt, fbdev->mem_phys);
+        break;
+    case VDMAFB_MEM_NOKMAP:
+        if (fbdev->mem_virt)
+            vunmap(fbdev->mem_virt);
+        dma_free_attrs(dev, fbdev->mem_size, fbdev->mem_cookie, fbdev->mem_phys,
+                       DMA_ATTR_WRITE_COMBINE | DMA_ATTR_NO_KERNEL_MAPPING);
+        break;
+    case VDMAFB_MEM_RESERVED:
+        if (fbdev->mem_virt)
+            memunmap(fbdev->mem_virt);
+        break;
+    }
+    fbdev->mem_virt = NULL;
+}
+
+/*
+ * 帧完整性校验
+ * 每行保存一个CRC32,只有报告为损坏(DAMAGE ioctl)或经驱动绘制/写入的行在vblank后重新计算,
+ * 再对前台缓冲区的行CRC数组做一次CRC32得到帧签名,开销与变化量成正比
+ */
+static void vdmafb_crc_damage(struct xilinx_vdmafb_dev *fbdev, u32 y, u32 height)
+{
+    struct vdmafb_crc *crc = &fbdev->crc;
+    unsigned long flags;
+
+    if (!READ_ONCE(crc->enabled) || y >= crc->nlines)
+        return;
+    height = min(height, crc->nlines - y);
+
+    spin_lock_irqsave(&crc->lock, flags);
+    bitmap_set(crc->dirty, y, height);
+    spin_unlock_irqrestore(&crc->lock, flags);
+}
+
+static void vdmafb_crc_work(struct work_struct *work)
+{
+    struct xilinx_vdmafb_dev *fbdev = container_of(work, struct xilinx_vdmafb_dev, crc.work);
+    struct vdmafb_crc *crc = &fbdev->crc;
+    struct fb_info *info = fbdev->fb_info;
+    u32 line_length = info->fix.line_length;
+    u32 yres = info->var.yres;
+    struct vdmafb_crc_info result = {0};
+    unsigned long flags;
+    unsigned int line;
+    u32 first;
+
+    /*迟锁存模式下front_addr可能已是下一帧,按刚扫描完的缓冲区计算*/
+    spin_lock_irqsave(&fbdev->lock, flags);
+    first = (u32)(fbdev->scanned_addr - info->fix.smem_start) / line_length;
+    result.vblank = fbdev->vblank_count;
+    result.timestamp_ns = ktime_to_ns(fbdev->vblank_time);
+    spin_unlock_irqrestore(&fbdev->lock, flags);
+
+    /*先取走损坏位图再计算,计算期间新的损坏会留到下一次*/
+    spin_lock_irqsave(&crc->lock, flags);
+    bitmap_copy(crc->snapshot, crc->dirty, crc->nlines);
+    bitmap_zero(crc->dirty, crc->nlines);
+    spin_unlock_irqrestore(&crc->lock, flags);
+
+    for_each_set_bit(line, crc->snapshot, crc->nlines) {
+        crc->line_crc[line] = crc32_le(~0, (u8 *)info->screen_base + line * line_length,
+                                       line_length);
+        result.lines_hashed++;
+    }
+
+    result.yoffset = first;
+    result.signature = crc32_le(~0, (u8 *)&crc->line_crc[first], yres * sizeof(u32));
+
+    spin_lock_irqsave(&crc->lock, flags);
+    crc->info = result;
+    spin_unlock_irqrestore(&crc->lock, flags);
+}
+
+static int vdmafb_crc_enable(struct xilinx_vdmafb_dev *fbdev, bool enable)
+{
+    struct vdmafb_crc *crc = &fbdev->crc;
+    unsigned long flags;
+    int ret;
+
+    if (!enable) {
+        WRITE_ONCE(crc->enabled, false);
+        cancel_work_sync(&crc->work);
+        return 0;
+    }
+    if (crc->enabled)
+        return 0;
+
+    /*计算CRC需要读显存*/
+    ret = vdmafb_kmap(fbdev);
+    if (ret)
+        return ret;
+
+    /*三块内存都分配成功才保存,否则下次使能会用到NULL位图*/
+    if (!crc->line_crc) {
+        struct device *dev = &fbdev->pdev->dev;
+        u32 nlines = fbdev->fb_info->var.yres_virtual;
+        u32 *line_crc;
+        unsigned long *dirty, *snapshot;
+
+        line_crc = devm_kcalloc(dev, nlines, sizeof(u32), GFP_KERNEL);
+        dirty = devm_kcalloc(dev, BITS_TO_LONGS(nlines), sizeof(long), GFP_KERNEL);
+        snapshot = devm_kcalloc(dev, BITS_TO_LONGS(nlines), sizeof(long), GFP_KERNEL);
+        if (!line_crc || !dirty || !snapshot) {
+            if (line_crc)
+                devm_kfree(dev, line_crc);
+            if (dirty)
+                devm_kfree(dev, dirty);
+            if (snapshot)
+                devm_kfree(dev, snapshot);
+            return -ENOMEM;
+        }
+        crc->nlines = nlines;
+        crc->dirty = dirty;
+        crc->snapshot = snapshot;
+        crc->line_crc = line_crc;
+    }
+
+    /*使能时全部行都需要计算一次*/
+    spin_lock_irqsave(&crc->lock, flags);
+    bitmap_fill(crc->dirty, crc->nlines);
+    spin_unlock_irqrestore(&crc->lock, flags);
+    WRITE_ONCE(crc->enabled, true);
+    return 0;
+}
+
+static void vdmafb_crc_get(struct xilinx_vdmafb_dev *fbdev, struct vdmafb_crc_info *out)
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&fbdev->crc.lock, flags);
+    *out = fbdev->crc.info;
+    spin_unlock_irqrestore(&fbdev->crc.lock, flags);
+}
+
+/*驱动内的绘制路径,绘制后标记损坏行*/
+static void vdmafb_fillrect(struct fb_info *info, const struct fb_fillrect *rect)
+{
+    cfb_fillrect(info, rect);
+    vdmafb_crc_damage(info->par, rect->dy, rect->height);
+}
+
+static void vdmafb_copyarea(struct fb_info *info, const struct fb_copyarea *area)
+{
+    cfb_copyarea(info, area);
+    vdmafb_crc_damage(info->par, area->dy, area->height);
+}
+
+static void vdmafb_imageblit(struct fb_info *info, const struct fb_image *image)
+{
+    cfb_imageblit(info, image);
+    vdmafb_crc_damage(info->par, image->dy, image->height);
+}
+
+/*内核使用者(fbcon)打开时建立内核映射,用户空间经mmap访问,不需要*/
+static int vdmafb_open(struct fb_info *info, int user)
+{
+    if (user)
+        return 0;
+    return vdmafb_kmap(info->par);
+}
+
+static ssize_t vdmafb_read(struct fb_info *info, char __user *buf,
+                           size_t count, loff_t *ppos)
+{
+    unsigned long p = *ppos;
+    int ret;
+
+    ret = vdmafb_kmap(info->par);
+    if (ret)
+        return ret;
+
+    if (p >= info->screen_size)
+        return 0;
+    count = min_t(size_t, count, info->screen_size - p);
+    if (copy_to_user(buf, info->screen_base + p, count))
+        return -EFAULT;
+
+    *ppos += count;
+    return count;
+}
+
+static ssize_t vdmafb_write(struct fb_info *info, const char __user *buf,
+                            size_t count, loff_t *ppos)
+{
+    unsigned long p = *ppos;
+    int ret;
+
+    ret = vdmafb_kmap(info->par);
+    if (ret)
+        return ret;
+
+    if (p >= info->screen_size)
+        return -EFBIG;
+    count = min_t(size_t, count, info->screen_size - p);
+    if (copy_from_user(info->screen_base + p, buf, count))
+        return -EFAULT;
+    vdmafb_crc_damage(info->par, p / info->fix.line_length,
+                      (p % info->fix.line_length + count + info->fix.line_length - 1) /
+                      info->fix.line_length);
+
+    *ppos += count;
+    return count;
+}
+
+static void vdmafb_capture_free(struct xilinx_vdmafb_dev *fbdev)
+{
+    struct vdmafb_capture *cap = &fbdev->cap;
+    struct device *dmadev = cap->chan->device->dev;
+    struct vdmafb_capture_buffer *buf;
+    unsigned long flags;
+    unsigned int i, j, k, count;
+
+    /*先清零个数,DQBUF等不再访问缓冲区*/
+    spin_lock_irqsave(&cap->lock, flags);
+    count = cap->count;
+    cap->count = 0;
+    spin_unlock_irqrestore(&cap->lock, flags);
+
+    for (i = 0; i < count; i++) {
+        buf = &cap->bufs[i];
+        for (j = 0; j < cap->nchunks && buf->chunks && buf->chunks[j]; j++) {
+            vdmafb_sim_del_region(buf->chunk_dma[j]);
+            dma_unmap_page(dmadev, buf->chunk_dma[j], VDMAFB_CAPTURE_CHUNK_SIZE,
+                           DMA_FROM_DEVICE);
+            /*分配后已split_page,逐页释放;已mmap的页由映射持有引用*/
+            for (k = 0; k < (1 << VDMAFB_CAPTURE_CHUNK_ORDER); k++)
+                __free_page(buf->chunks[j] + k);
+        }
+        kfree(buf->chunks);
+        kfree(buf->chunk_dma);
+        memset(buf, 0, sizeof(*buf));
+    }
+}
+
+static int vdmafb_capture_alloc(struct xilinx_vdmafb_dev *fbdev, unsigned int count)
+{
+    struct vdmafb_capture *cap = &fbdev->cap;
+    struct device *dmadev = cap->chan->device->dev;
+    struct vdmafb_capture_buffer *buf;
+    struct page *page;
+    unsigned int i, j, k;
+
+    cap->nchunks = DIV_ROUND_UP(fbdev->buf_size, VDMAFB_CAPTURE_CHUNK_SIZE);
+    cap->buf_size = cap->nchunks * VDMAFB_CAPTURE_CHUNK_SIZE;
+
+    for (i = 0; i < count; i++) {
+        buf = &cap->bufs[i];
+        cap->count = i + 1;
+        buf->chunks = kcalloc(cap->nchunks, sizeof(*buf->chunks), GFP_KERNEL);
+        buf->chunk_dma = kcalloc(cap->nchunks, sizeof(*buf->chunk_dma), GFP_KERNEL);
+        if (!buf->chunks || !buf->chunk_dma)
+            goto fail;
+
+        for (j = 0; j < cap->nchunks; j++) {
+            /*清零,避免把内核残留数据暴露给用户空间*/
+            page = alloc_pages(GFP_KERNEL | __GFP_ZERO | __GFP_NOWARN,
+                               VDMAFB_CAPTURE_CHUNK_ORDER);
+            if (!page)
+                goto fail;
+            /*拆分成独立页,每页有自己的引用计数,才能用vm_insert_page映射*/
+            split_page(page, VDMAFB_CAPTURE_CHUNK_ORDER);
+
+            buf->chunk_dma[j] = dma_map_page(dmadev, page, 0, VDMAFB_CAPTURE_CHUNK_SIZE,
+                                             DMA_FROM_DEVICE);
+            if (dma_mapping_error(dmadev, buf->chunk_dma[j])) {
+                for (k = 0; k < (1 << VDMAFB_CAPTURE_CHUNK_ORDER); k++)
+                    __free_page(page + k);
+                goto fail;
+            }
+            vdmafb_sim_add_region(buf->chunk_dma[j], page_address(page),
+                                  VDMAFB_CAPTURE_CHUNK_SIZE);
+            buf->chunks[j] = page;
+        }
+        buf->state = VDMAFB_CAP_FREE;
+        buf->info.index = i;
+        buf->info.bytesused = fbdev->buf_size;
+    }
+
+    return 0;
+
+fail:
+    vdmafb_capture_free(fbdev);
+    return -ENOMEM;
+}
+
+/*拷贝完成回调,把缓冲区交给用户*/
+static void vdmafb_capture_done(void *param)
+{
+    struct xilinx_vdmafb_dev *fbdev = param;
+    struct vdmafb_capture *cap = &fbdev->cap;
+    struct device *dmadev = cap->chan->device->dev;
+    struct vdmafb_capture_buffer *buf = NULL;
+    unsigned long flags;
+    unsigned int i, j;
+
+    /*同一时刻只有一个缓冲区在拷贝;拷贝期间缓冲区不会被释放,同步缓存不需要持锁*/
+    spin_lock_irqsave(&cap->lock, flags);
+    for (i = 0; i < cap->count; i++)
+        if (cap->bufs[i].state == VDMAFB_CAP_BUSY)
+            buf = &cap->bufs[i];
+    spin_unlock_irqrestore(&cap->lock, flags);
+    if (!buf)
+        return;
+
+    /*作废CPU缓存中的旧数据,用户经可缓存映射读取*/
+    for (j = 0; j < cap->nchunks; j++)
+        dma_sync_single_for_cpu(dmadev, buf->chunk_dma[j], VDMAFB_CAPTURE_CHUNK_SIZE,
+                                DMA_FROM_DEVICE);
+
+    spin_lock_irqsave(&cap->lock, flags);
+    buf->state = VDMAFB_CAP_DONE;
+    cap->busy = false;
+    cap->done++;
+    spin_unlock_irqrestore(&cap->lock, flags);
+
+    wake_up_interruptible_all(&cap->wait);
+}
+
+static int vdmafb_capture_copy(struct xilinx_vdmafb_dev *fbdev,
+                               struct vdmafb_capture_buffer *buf, dma_addr_t src)
+{
+    struct vdmafb_capture *cap = &fbdev->cap;
+    struct device *dmadev = cap->chan->device->dev;
+    struct dma_async_tx_descriptor *tx;
+    size_t left = fbdev->buf_size;
+    size_t len;
+    unsigned long flags;
+    unsigned int j;
+
+    for (j = 0; j < cap->nchunks; j++) {
+        len = min_t(size_t, left, VDMAFB_CAPTURE_CHUNK_SIZE);
+        dma_sync_single_for_device(dmadev, buf->chunk_dma[j], len, DMA_FROM_DEVICE);
+
+        /*只有最后一块产生完成中断*/
+        flags = DMA_CTRL_ACK;
+        if (j == cap->nchunks - 1)
+            flags |= DMA_PREP_INTERRUPT;
+        tx = dmaengine_prep_dma_memcpy(cap->chan, buf->chunk_dma[j],
+                                       src + j * VDMAFB_CAPTURE_CHUNK_SIZE, len, flags);
+        if (!tx)
+            goto err;
+        if (j == cap->nchunks - 1) {
+            tx->callback = vdmafb_capture_done;
+            tx->callback_param = fbdev;
+        }
+        if (dma_submit_error(dmaengine_submit(tx)))
+            goto err;
+        left -= len;
+    }
+
+    dma_async_issue_pending(cap->chan);
+    return 0;
+
+err:
+    dmaengine_terminate_async(cap->chan);
+    return -EIO;
+}
+
+/*
+ * vblank时调用,按模式和间隔触发一次抓取
+ * 优先使用空闲缓冲区,没有则覆盖最旧的未取走帧
+ */
+static void vdmafb_capture_vblank(struct xilinx_vdmafb_dev *fbdev, dma_addr_t src,
+                                  u64 vblank, ktime_t ts)
+{
+    struct vdmafb_capture *cap = &fbdev->cap;
+    struct vdmafb_capture_buffer *buf = NULL;
+    unsigned long flags;
+    int i, idx = -1;
+
+    spin_lock_irqsave(&cap->lock, flags);
+    if (!cap->active || cap->busy || --cap->countdown)
+        goto unlock;
+    cap->countdown = cap->interval;
+
+    for (i = 0; i < cap->count; i++) {
+        if (cap->bufs[i].state == VDMAFB_CAP_FREE) {
+            idx = i;
+            break;
+        }
+    }
+    for (i = 0; idx < 0 && i < cap->count; i++) {
+        if (cap->bufs[i].state != VDMAFB_CAP_DONE)
+            continue;
+        if (idx < 0 || cap->bufs[i].info.sequence < cap->bufs[idx].info.sequence)
+            idx = i;
+    }
+    if (idx < 0)
+        goto unlock;                    /*所有缓冲区都在用户手中,跳过本帧*/
+
+    buf = &cap->bufs[idx];
+    buf->state = VDMAFB_CAP_BUSY;
+    buf->info.sequence = cap->sequence++;
+    buf->info.vblank = vblank;
+    buf->info.timestamp_ns = ktime_to_ns(ts);
+    cap->busy = true;
+    if (cap->mode == VDMAFB_CAPTURE_ONESHOT)
+        cap->active = false;
+unlock:
+    spin_unlock_irqrestore(&cap->lock, flags);
+
+    if (buf && vdmafb_capture_copy(fbdev, buf, src)) {
+        spin_lock_irqsave(&cap->lock, flags);
+        buf->state = VDMAFB_CAP_FREE;
+        cap->busy = false;
+        cap->done++;
+        spin_unlock_irqrestore(&cap->lock, flags);
+        wake_up_interruptible_all(&cap->wait);
+    }
+}
+
+static void vdmafb_capture_stop(struct xilinx_vdmafb_dev *fbdev)
+{
+    struct vdmafb_capture *cap = &fbdev->cap;
+    unsigned long flags;
+
+    mutex_lock(&cap->mutex);
+    if (!cap->chan) {
+        mutex_unlock(&cap->mutex);
+        return;
+    }
+
+    spin_lock_irqsave(&cap->lock, flags);
+    cap->active = false;
+    spin_unlock_irqrestore(&cap->lock, flags);
+
+    /*等待进行中的拷贝完成*/
+    if (!wait_event_timeout(cap->wait, !READ_ONCE(cap->busy), msecs_to_jiffies(100)))
+        dmaengine_terminate_sync(cap->chan);
+
+    vdmafb_capture_free(fbdev);
+    dma_release_channel(cap->chan);
+    cap->chan = NULL;
+    mutex_unlock(&cap->mutex);
+
+    wake_up_interruptible_all(&cap->wait);
+}
+
+static int vdmafb_capture_start(struct xilinx_vdmafb_dev *fbdev,
+                                struct vdmafb_capture_start *req)
+{
+    struct device *dev = &fbdev->pdev->dev;
+    struct vdmafb_capture *cap = &fbdev->cap;
+    dma_cap_mask_t mask;
+    unsigned long flags;
+    int ret = 0;
+
+    if (req->mode != VDMAFB_CAPTURE_ONESHOT && req->mode != VDMAFB_CAPTURE_CONTINUOUS)
+        return -EINVAL;
+    if (req->count < 1 || req->count > VDMAFB_CAPTURE_MAX_BUFS)
+        return -EINVAL;
+
+    mutex_lock(&cap->mutex);
+    /*缓冲区个数变化时重新分配*/
+    if (cap->count && cap->count != req->count) {
+        mutex_unlock(&cap->mutex);
+        vdmafb_capture_stop(fbdev);
+        mutex_lock(&cap->mutex);
+    }
+
+    if (!cap->chan) {
+        /*优先使用设备树中dma-names = "capture"的通道,否则任取一个memcpy通道*/
+        cap->chan = dma_request_chan(dev, "capture");
+        if (IS_ERR(cap->chan)) {
+            dma_cap_zero(mask);
+            dma_cap_set(DMA_MEMCPY, mask);
+            cap->chan = dma_request_chan_by_mask(&mask);
+        }
+        if (IS_ERR(cap->chan)) {
+            ret = PTR_ERR(cap->chan);
+            cap->chan = NULL;
+            dev_err(dev, "Failed to request capture dma channel\n");
+            goto out;
+        }
+    }
+
+    if (!cap->count) {
+        ret = vdmafb_capture_alloc(fbdev, req->count);
+        if (ret) {
+            dev_err(dev, "Failed to allocate capture buffers\n");
+            dma_release_channel(cap->chan);
+            cap->chan = NULL;
+            goto out;
+        }
+    }
+
+    spin_lock_irqsave(&cap->lock, flags);
+    cap->mode = req->mode;
+    cap->interval = req->interval ? req->interval : 1;
+    cap->countdown = 1;                 /*下一次vblank即抓取*/
+    cap->active = true;
+    spin_unlock_irqrestore(&cap->lock, flags);
+
+    req->buf_size = cap->buf_size;
+    req->mmap_offset = fbdev->mem_size;
+out:
+    mutex_unlock(&cap->mutex);
+    return ret;
+}
+
+/*
+ * 取走最早抓取的一帧,调用者不持有fb_info锁
+ * 没有完成的帧时等待下一次拷贝结束,最多100ms;显示关闭或休眠期间
+ * 不会产生新帧,超时返回-EAGAIN
+ */
+static int vdmafb_capture_dqbuf(struct xilinx_vdmafb_dev *fbdev,
+                                struct vdmafb_capture_buf *out)
+{
+    struct vdmafb_capture *cap = &fbdev->cap;
+    unsigned long flags;
+    bool pending;
+    u64 done;
+    long ret;
+    int i, idx;
+
+    for (;;) {
+        idx = -1;
+        spin_lock_irqsave(&cap->lock, flags);
+        if (!cap->count) {
+            spin_unlock_irqrestore(&cap->lock, flags);
+            return -ENODEV;
+        }
+        for (i = 0; i < cap->count; i++) {
+            if (cap->bufs[i].state != VDMAFB_CAP_DONE)
+                continue;
+            if (idx < 0 || cap->bufs[i].info.sequence < cap->bufs[idx].info.sequence)
+                idx = i;
+        }
+        if (idx >= 0) {
+            cap->bufs[idx].state = VDMAFB_CAP_USER;
+            *out = cap->bufs[idx].info;
+        }
+        /*
+         * 有拷贝在进行,或者还会抓取且有空闲缓冲区时才会有新帧;
+         * 单次抓取已取走、或所有缓冲区都在用户手中时直接返回
+         */
+        pending = cap->busy;
+        for (i = 0; !pending && cap->active && i < cap->count; i++)
+            pending = cap->bufs[i].state == VDMAFB_CAP_FREE;
+        done = cap->done;
+        spin_unlock_irqrestore(&cap->lock, flags);
+
+        if (idx >= 0)
+            return 0;
+        if (!pending)
+            return -EAGAIN;
+
+        ret = wait_event_interruptible_timeout(cap->wait,
+                                               READ_ONCE(cap->done) != done ||
+                                               !READ_ONCE(cap->count),
+                                               msecs_to_jiffies(100));
+        if (ret < 0)
+            return ret;
+        if (ret == 0)
+            return -EAGAIN;
+    }
+}
+
+static int vdmafb_capture_qbuf(struct xilinx_vdmafb_dev *fbdev, u32 index)
+{
+    struct vdmafb_capture *cap = &fbdev->cap;
+    unsigned long flags;
+    int ret = -EINVAL;
+
+    spin_lock_irqsave(&cap->lock, flags);
+    if (index < cap->count && cap->bufs[index].state == VDMAFB_CAP_USER) {
+        cap->bufs[index].state = VDMAFB_CAP_FREE;
+        ret = 0;
+    }
+    spin_unlock_irqrestore(&cap->lock, flags);
+    return ret;
+}
+
+/*mmap偏移在显存之后的部分映射抓屏缓冲区,普通可缓存页,只读*/
+static int vdmafb_capture_mmap(struct xilinx_vdmafb_dev *fbdev, struct vm_area_struct *vma)
+{
+    struct vdmafb_capture *cap = &fbdev->cap;
+    unsigned long off = (vma->vm_pgoff << PAGE_SHIFT) - fbdev->mem_size;
+    unsigned long size = vma->vm_end - vma->vm_start;
+    unsigned long addr, within;
+    struct vdmafb_capture_buffer *buf;
+    int ret = 0;
+
+    if (vma->vm_flags & VM_WRITE)
+        return -EPERM;
+
+    mutex_lock(&cap->mutex);
+    if (!cap->count || off >= cap->count * cap->buf_size ||
+        size > cap->count * cap->buf_size - off) {
+        ret = -EINVAL;
+        goto out;
+    }
+
+    vdmafb_vm_flags_clear(vma, VM_MAYWRITE);
+    vdmafb_vm_flags_set(vma, VM_DONTEXPAND | VM_DONTDUMP);
+    for (addr = vma->vm_start; addr < vma->vm_end; addr += PAGE_SIZE, off += PAGE_SIZE) {
+        buf = &cap->bufs[off / cap->buf_size];
+        within = off % cap->buf_size;
+        ret = vm_insert_page(vma, addr,
+                             buf->chunks[within / VDMAFB_CAPTURE_CHUNK_SIZE] +
+                             ((within % VDMAFB_CAPTURE_CHUNK_SIZE) >> PAGE_SHIFT));
+        if (ret)
+            break;
+    }
+out:
+    mutex_unlock(&cap->mutex);
+    return ret;
+}
+
+static void vdmafb_frame_done(void *param);
+
+/*
+ * 为一帧提交VDMA描述符,调用者持有lock
+ * 每帧提交一个描述符,使帧完成回调持续产生,作为vblank时钟.
+ * 帧完成回调(tasklet)、迟锁存定时器(硬中断)和ioctl都会提交,
+ * 共用的描述符模板和提交顺序由lock保护
+ */
+static int vdmafb_submit_frame(struct xilinx_vdmafb_dev *fbdev, dma_addr_t addr)
+{
+    struct dma_async_tx_descriptor *tx_desc;
+    dma_cookie_t cookie;
+
+    lockdep_assert_held(&fbdev->lock);
+    if (fbdev->queued >= VDMAFB_MAX_QUEUED)
+        return -EBUSY;
+
+    fbdev->dma_template->src_start = addr;
+    tx_desc = dmaengine_prep_interleaved_dma(fbdev->vdma, fbdev->dma_template,
+                                             DMA_CTRL_ACK | DMA_PREP_INTERRUPT);
+    if (!tx_desc)
+        return -ENOMEM;
+
+    tx_desc->callback = vdmafb_frame_done;
+    tx_desc->callback_param = fbdev;
+
+    cookie = dmaengine_submit(tx_desc);
+    if (dma_submit_error(cookie))
+        return -EIO;
+
+    fbdev->queued_addr[(fbdev->queued_head + fbdev->queued) % VDMAFB_MAX_QUEUED] = addr;
+    fbdev->queued++;
+    dma_async_issue_pending(fbdev->vdma);
+    return 0;
+}
+
+/*取出最早提交的描述符对应的缓冲区,即刚完成扫描的缓冲区,调用者持有lock*/
+static dma_addr_t vdmafb_complete_frame(struct xilinx_vdmafb_dev *fbdev)
+{
+    dma_addr_t addr;
+
+    if (!fbdev->queued)
+        return fbdev->front_addr;
+    addr = fbdev->queued_addr[fbdev->queued_head];
+    fbdev->queued_head = (fbdev->queued_head + 1) % VDMAFB_MAX_QUEUED;
+    fbdev->queued--;
+    return addr;
+}
+
+/*取出最新的待显示缓冲区作为前台缓冲区,调用者持有lock*/
+static dma_addr_t vdmafb_take_pending(struct xilinx_vdmafb_dev *fbdev)
+{
+    if (fbdev->pending_addr) {
+        fbdev->front_addr = fbdev->pending_addr;
+        fbdev->pending_addr = 0;
+    }
+    return fbdev->front_addr;
+}
+
+/*
+ * 记录帧完成时刻并预测下一次vblank,调用者持有lock
+ * 帧周期初值由时序参数计算,之后用实测间隔做1/8指数滑动平均修正
+ */
+static void vdmafb_update_vblank(struct xilinx_vdmafb_dev *fbdev, ktime_t now)
+{
+    u64 period = fbdev->frame_period_ns;
+    u64 delta;
+
+    if (fbdev->vblank_count) {
+        delta = ktime_to_ns(ktime_sub(now, fbdev->vblank_time));
+        /*只用相邻帧的间隔修正周期,丢帧的间隔不参与*/
+        if (delta > period / 2 && delta < period + period / 2)
+            period = period - (period >> 3) + (delta >> 3);
+    }
+
+    fbdev->frame_period_ns = period;
+    fbdev->vblank_time = now;
+    fbdev->next_vblank = ktime_add_ns(now, period);
+    fbdev->vblank_count++;
+}
+
+/*迟锁存提交时刻 = 预测的vblank - 提前量*/
+static ktime_t vdmafb_latch_deadline(struct xilinx_vdmafb_dev *fbdev)
+{
+    return ktime_sub_us(fbdev->next_vblank, fbdev->latch_margin_us);
+}
+
+/*
+ * vblank模式下补交一帧,调用者持有lock
+ * 已有描述符在排队时不再提交,避免多排一帧增加延迟;
+ * 提交失败时一个帧周期后由定时器重试,否则帧完成回调停止,vblank时钟随之停止
+ */
+static void vdmafb_submit_vblank(struct xilinx_vdmafb_dev *fbdev)
+{
+    int ret;
+
+    if (fbdev->queued)
+        return;
+    ret = vdmafb_submit_frame(fbdev, vdmafb_take_pending(fbdev));
+    if (ret) {
+        dev_err_ratelimited(&fbdev->pdev->dev, "Failed to submit frame: %d, retrying\n", ret);
+        hrtimer_start(&fbdev->latch_timer, ktime_add_ns(ktime_get(), fbdev->frame_period_ns),
+                      HRTIMER_MODE_ABS);
+    }
+}
+
+/*VDMA帧完成回调(tasklet上下文)*/
+static void vdmafb_frame_done(void *param)
+{
+    struct xilinx_vdmafb_dev *fbdev = param;
+    ktime_t now = ktime_get();
+    dma_addr_t scanned;
+    u64 vblank;
+    unsigned long flags;
+
+    spin_lock_irqsave(&fbdev->lock, flags);
+    if (!fbdev->running) {
+        spin_unlock_irqrestore(&fbdev->lock, flags);
+        return;
+    }
+
+    vdmafb_update_vblank(fbdev, now);
+    scanned = vdmafb_complete_frame(fbdev);     //刚完成扫描的缓冲区
+    fbdev->scanned_addr = scanned;
+    vblank = fbdev->vblank_count;
+
+    if (fbdev->present_mode == VDMAFB_PRESENT_LATE_LATCH)
+        /*按本次帧完成的相位重新对齐迟锁存定时器,由定时器提交下一帧*/
+        hrtimer_start(&fbdev->latch_timer, vdmafb_latch_deadline(fbdev),
+                      HRTIMER_MODE_ABS);
+    else
+        vdmafb_submit_vblank(fbdev);
+    spin_unlock_irqrestore(&fbdev->lock, flags);
+
+    vdmafb_capture_vblank(fbdev, scanned, vblank, now);
+    if (READ_ONCE(fbdev->crc.enabled))
+        queue_work(system_highpri_wq, &fbdev->crc.work);
+    wake_up_interruptible_all(&fbdev->vblank_wait);
+}
+
+/*
+ * 迟锁存定时器,在预测的vblank前latch_margin_us触发
+ * 此时提交最新pan的缓冲区,VDMA取下一帧时即可生效
+ * 定时器按预测周期自行续期,帧完成回调只负责校正相位;提交失败时下一周期再提交.
+ * vblank模式下只用于提交失败后的重试
+ */
+static enum hrtimer_restart vdmafb_latch_timer_fn(struct hrtimer *timer)
+{
+    struct xilinx_vdmafb_dev *fbdev =
+        container_of(timer, struct xilinx_vdmafb_dev, latch_timer);
+    enum hrtimer_restart restart = HRTIMER_NORESTART;
+    unsigned long flags;
+    int ret;
+
+    spin_lock_irqsave(&fbdev->lock, flags);
+    if (!fbdev->running)
+        goto out;
+
+    if (fbdev->present_mode != VDMAFB_PRESENT_LATE_LATCH) {
+        vdmafb_submit_vblank(fbdev);
+        goto out;
+    }
+
+    ret = vdmafb_submit_frame(fbdev, vdmafb_take_pending(fbdev));
+    if (ret)
+        dev_err_ratelimited(&fbdev->pdev->dev, "Failed to latch frame: %d\n", ret);
+    hrtimer_forward_now(timer, ns_to_ktime(fbdev->frame_period_ns));
+    restart = HRTIMER_RESTART;
+out:
+    spin_unlock_irqrestore(&fbdev->lock, flags);
+    return restart;
+}
+
+/*切换显示提交模式*/
+static int vdmafb_set_present_mode(struct xilinx_vdmafb_dev *fbdev,
+                                   struct vdmafb_present_mode *pm)
+{
+    u32 margin = pm->latch_margin_us ? pm->latch_margin_us : VDMAFB_DEFAULT_MARGIN_US;
+    unsigned long flags;
+
+    if (pm->mode != VDMAFB_PRESENT_VBLANK && pm->mode != VDMAFB_PRESENT_LATE_LATCH)
+        return -EINVAL;
+
+    /*提前量不能超过半帧,否则提交会落到上一帧*/
+    if ((u64)margin * NSEC_PER_USEC > fbdev->frame_period_ns / 2)
+        return -EINVAL;
+
+    spin_lock_irqsave(&fbdev->lock, flags);
+    fbdev->latch_margin_us = margin;
+    if (fbdev->present_mode == pm->mode) {
+        spin_unlock_irqrestore(&fbdev->lock, flags);
+        return 0;
+    }
+    fbdev->present_mode = pm->mode;
+    if (pm->mode == VDMAFB_PRESENT_LATE_LATCH)
+        hrtimer_start(&fbdev->latch_timer, vdmafb_latch_deadline(fbdev),
+                      HRTIMER_MODE_ABS);
+    spin_unlock_irqrestore(&fbdev->lock, flags);
+
+    if (pm->mode == VDMAFB_PRESENT_VBLANK) {
+        /*
+         * 停止定时器后由帧完成回调接管提交.定时器可能已为当前帧提交了下一帧,
+         * 只有队列为空(定时器还未提交)时才补交一帧以维持回调
+         */
+        hrtimer_cancel(&fbdev->latch_timer);
+        spin_lock_irqsave(&fbdev->lock, flags);
+        if (fbdev->running && fbdev->present_mode == VDMAFB_PRESENT_VBLANK)
+            vdmafb_submit_vblank(fbdev);
+        spin_unlock_irqrestore(&fbdev->lock, flags);
+    }
+
+    return 0;
+}
+
+static void vdmafb_get_vblank(struct xilinx_vdmafb_dev *fbdev,
+                              struct vdmafb_vblank_info *vbl)
+{
+    unsigned long flags;
+
+    memset(vbl, 0, sizeof(*vbl));
+    spin_lock_irqsave(&fbdev->lock, flags);
+    vbl->sequence = fbdev->vblank_count;
+    vbl->last_vblank_ns = ktime_to_ns(fbdev->vblank_time);
+    vbl->period_ns = fbdev->frame_period_ns;
+    vbl->next_vblank_ns = ktime_to_ns(fbdev->next_vblank);
+    vbl->mode = fbdev->present_mode;
+    vbl->latch_margin_us = fbdev->latch_margin_us;
+    if (fbdev->present_mode == VDMAFB_PRESENT_LATE_LATCH)
+        vbl->deadline_ns = ktime_to_ns(vdmafb_latch_deadline(fbdev));
+    else
+        /*帧完成回调中提交,须在下一次vblank之前pan*/
+        vbl->deadline_ns = vbl->next_vblank_ns;
+    spin_unlock_irqrestore(&fbdev->lock, flags);
+}
+
+/*等待下一次vblank*/
+static int vdmafb_wait_for_vsync(struct xilinx_vdmafb_dev *fbdev)
+{
+    u64 count = READ_ONCE(fbdev->vblank_count);
+    long ret;
+
+    ret = wait_event_interruptible_timeout(fbdev->vblank_wait,
+                                           READ_ONCE(fbdev->vblank_count) != count,
+                                           msecs_to_jiffies(100));
+    if (ret < 0)
+        return ret;
+    if (ret == 0)
+        return -ETIMEDOUT;
+    return 0;
+}
+
+/*平移显示,只记录缓冲区地址,由帧完成回调或迟锁存定时器提交*/
+static int vdmafb_pan_display(struct fb_var_screeninfo *var, struct fb_info *info)
+{
+    struct xilinx_vdmafb_dev *fbdev = info->par;
+    unsigned long flags;
+
+    if (var->xoffset || var->yoffset % info->var.yres)
+        return -EINVAL;
+    if (var->yoffset + info->var.yres > info->var.yres_virtual)
+        return -EINVAL;
+
+    spin_lock_irqsave(&fbdev->lock, flags);
+    fbdev->pending_addr = info->fix.smem_start +
+                          var->yoffset * info->fix.line_length;
+    spin_unlock_irqrestore(&fbdev->lock, flags);
+
+    return 0;
+}
+
+static void vdmafb_display_off(struct xilinx_vdmafb_dev *fbdev);
+static int vdmafb_display_on(struct xilinx_vdmafb_dev *fbdev);
+
+/*
+ * 关闭显示时停止VTC和VDMA,显存内容保留.
+ * 成功返回后fb核心发出FB_EVENT_BLANK,触摸屏等驱动据此进入睡眠.
+ * 帧完成回调随之停止,FBIO_WAITFORVSYNC在关闭期间超时返回
+ */
+static int vdmafb_blank(int blank, struct fb_info *info)
+{
+    struct xilinx_vdmafb_dev *fbdev = info->par;
+    int ret;
+
+    if (blank == FB_BLANK_UNBLANK) {
+        if (!fbdev->blanked)
+            return 0;
+        ret = vdmafb_display_on(fbdev);
+        if (ret)
+            return ret;
+        fbdev->blanked = false;
+        return 0;
+    }
+
+    if (!fbdev->blanked) {
+        vdmafb_display_off(fbdev);
+        fbdev->blanked = true;
+    }
+    return 0;
+}
+
+/*
+ * 显存mmap
+ * 显存物理连续且按VDMAFB_MEM_ALIGN对齐分配.
+ * 支持PMD级大页的内核(arm64、ARM LPAE + THP)上,在对齐的区间内以大页建立映射,
+ * 一个TLB项即可覆盖2MB显存;用户虚拟地址也需按大页对齐(可用mmap地址提示).
+ * Cortex-A9等非LPAE内核的用户页表只支持4KB小页,映射方式与fb_mmap相同(remap_pfn_range),
+ * 没有TLB上的收益.
+ */
+static int vdmafb_mmap_check(struct xilinx_vdmafb_dev *fbdev, struct vm_area_struct *vma)
+{
+    unsigned long off = vma->vm_pgoff << PAGE_SHIFT;
+    unsigned long size = vma->vm_end - vma->vm_start;
+
+    if (off >= fbdev->mem_size || size > fbdev->mem_size - off)
+        return -EINVAL;
+    return 0;
+}
+
+#ifdef VDMAFB_HUGE_MMAP
+/*6.6起huge_fault按页阶传入大小,5.2起vmf_insert_pfn_pmd只需vmf*/
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 6, 0)
+static vm_fault_t vdmafb_vm_huge_fault(struct vm_fault *vmf, unsigned int order)
+#else
+static vm_fault_t vdmafb_vm_huge_fault(struct vm_fault *vmf, enum page_entry_size pe_size)
+#endif
+{
+    struct vm_area_struct *vma = vmf->vma;
+    struct xilinx_vdmafb_dev *fbdev = vma->vm_private_data;
+    unsigned long haddr = vmf->address & HPAGE_PMD_MASK;
+    phys_addr_t phys;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 6, 0)
+    if (order != HPAGE_PMD_ORDER)
+#else
+    if (pe_size != PE_SIZE_PMD)
+#endif
+        return VM_FAULT_FALLBACK;
+    if (haddr < vma->vm_start || haddr + HPAGE_PMD_SIZE > vma->vm_end)
+        return VM_FAULT_FALLBACK;
+
+    /*大页对应的物理地址也必须按大页对齐*/
+    phys = fbdev->fb_info->fix.smem_start +
+           ((vma->vm_pgoff << PAGE_SHIFT) + (haddr - vma->vm_start));
+    if (!IS_ALIGNED(phys, HPAGE_PMD_SIZE))
+        return VM_FAULT_FALLBACK;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 2, 0)
+    return vmf_insert_pfn_pmd(vmf, phys_to_pfn_t(phys, PFN_DEV), vmf->flags & FAULT_FLAG_WRITE);
+#else
+    return vmf_insert_pfn_pmd(vma, haddr, vmf->pmd, phys_to_pfn_t(phys, PFN_DEV),
+                              vmf->flags & FAULT_FLAG_WRITE);
+#endif
+}
+
+static vm_fault_t vdmafb_vm_fault(struct vm_fault *vmf)
+{
+    struct vm_area_struct *vma = vmf->vma;
+    struct xilinx_vdmafb_dev *fbdev = vma->vm_private_data;
+    unsigned long pfn = PHYS_PFN(fbdev->fb_info->fix.smem_start) + vmf->pgoff;
+
+    return vmf_insert_pfn(vma, vmf->address, pfn);
+}
+
+static const struct vm_operations_struct vdmafb_vm_ops = {
+    .fault = vdmafb_vm_fault,
+    .huge_fault = vdmafb_vm_huge_fault,
+};
+
+static int vdmafb_mmap_fb(struct fb_info *info, struct vm_area_struct *vma)
+{
+    struct xilinx_vdmafb_dev *fbdev = info->par;
+    int ret;
+
+    ret = vdmafb_mmap_check(fbdev, vma);
+    if (ret)
+        return ret;
+
+    vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+    vdmafb_vm_flags_set(vma, VM_PFNMAP | VM_IO | VM_DONTEXPAND | VM_DONTDUMP | VM_HUGEPAGE);
+    vma->vm_private_data = fbdev;
+    vma->vm_ops = &vdmafb_vm_ops;
+    return 0;
+}
+#else
+static int vdmafb_mmap_fb(struct fb_info *info, struct vm_area_struct *vma)
+{
+    struct xilinx_vdmafb_dev *fbdev = info->par;
+    int ret;
+
+    ret = vdmafb_mmap_check(fbdev, vma);
+    if (ret)
+        return ret;
+
+    vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+    vdmafb_vm_flags_set(vma, VM_IO | VM_DONTEXPAND | VM_DONTDUMP);
+    return remap_pfn_range(vma, vma->vm_start,
+                           PHYS_PFN(info->fix.smem_start) + vma->vm_pgoff,
+                           vma->vm_end - vma->vm_start, vma->vm_page_prot);
+}
+#endif
+
+/*显存之后的偏移用于映射抓屏缓冲区*/
+static int vdmafb_mmap(struct fb_info *info, struct vm_area_struct *vma)
+{
+    struct xilinx_vdmafb_dev *fbdev = info->par;
+
+    if ((vma->vm_pgoff << PAGE_SHIFT) >= fbdev->mem_size)
+        return vdmafb_capture_mmap(fbdev, vma);
+    return vdmafb_mmap_fb(info, vma);
+}
+
+/*
+ * 等待后重新获取fb_info锁,等待期间fb可能已注销(驱动解绑)
+ * 5.3之前lock_fb_info在fb已注销时解锁并返回0,fb_ioctl返回后还会再解锁一次,
+ * 这里重新持锁保持平衡;之后的内核lock_fb_info不再检查
+ */
+static int vdmafb_relock_fb_info(struct fb_info *info)
+{
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 3, 0)
+    if (!lock_fb_info(info)) {
+        mutex_lock(&info->lock);
+        return -ENODEV;
+    }
+#else
+    lock_fb_info(info);
+#endif
+    return 0;
+}
+
+static int vdmafb_ioctl(struct fb_info *info, unsigned int cmd, unsigned long arg)
+{
+    struct xilinx_vdmafb_dev *fbdev = info->par;
+    void __user *argp = (void __user *)arg;
+    struct vdmafb_present_mode pm;
+    struct vdmafb_vblank_info vbl;
+    struct vdmafb_capture_start cs;
+    struct vdmafb_capture_buf cb;
+    struct vdmafb_damage dmg;
+    struct vdmafb_crc_info ci;
+    u32 index;
+    int ret;
+
+    /*
+     * fb_ioctl在持有fb_info锁时调用,等待vblank或抓屏期间释放该锁,
+     * 以免阻塞其它进程的pan、FBIOGET_VSCREENINFO等ioctl
+     */
+    switch (cmd) {
+    case FBIO_WAITFORVSYNC:
+        unlock_fb_info(info);
+        ret = vdmafb_wait_for_vsync(fbdev);
+        if (vdmafb_relock_fb_info(info))
+            return -ENODEV;
+        return ret;
+
+    case VDMAFB_IOCTL_SET_PRESENT_MODE:
+        if (copy_from_user(&pm, argp, sizeof(pm)))
+            return -EFAULT;
+        return vdmafb_set_present_mode(fbdev, &pm);
+
+    case VDMAFB_IOCTL_GET_VBLANK:
+        vdmafb_get_vblank(fbdev, &vbl);
+        if (copy_to_user(argp, &vbl, sizeof(vbl)))
+            return -EFAULT;
+        return 0;
+
+    case VDMAFB_IOCTL_CAPTURE_START:
+        if (copy_from_user(&cs, argp, sizeof(cs)))
+            return -EFAULT;
+        ret = vdmafb_capture_start(fbdev, &cs);
+        if (ret)
+            return ret;
+        if (copy_to_user(argp, &cs, sizeof(cs)))
+            return -EFAULT;
+        return 0;
+
+    case VDMAFB_IOCTL_CAPTURE_STOP:
+        vdmafb_capture_stop(fbdev);
+        return 0;
+
+    case VDMAFB_IOCTL_CAPTURE_DQBUF:
+        unlock_fb_info(info);
+        ret = vdmafb_capture_dqbuf(fbdev, &cb);
+        if (vdmafb_relock_fb_info(info))
+            return -ENODEV;
+        if (ret)
+            return ret;
+        if (copy_to_user(argp, &cb, sizeof(cb)))
+            return -EFAULT;
+        return 0;
+
+    case VDMAFB_IOCTL_CAPTURE_QBUF:
+        if (get_user(index, (u32 __user *)argp))
+            return -EFAULT;
+        return vdmafb_capture_qbuf(fbdev, index);
+
+    case VDMAFB_IOCTL_CRC_ENABLE:
+        if (get_user(index, (u32 __user *)argp))
+            return -EFAULT;
+        return vdmafb_crc_enable(fbdev, index != 0);
+
+    case VDMAFB_IOCTL_DAMAGE:
+        if (copy_from_user(&dmg, argp, sizeof(dmg)))
+            return -EFAULT;
+        vdmafb_crc_damage(fbdev, dmg.y, dmg.height);
+        return 0;
+
+    case VDMAFB_IOCTL_GET_CRC:
+        vdmafb_crc_get(fbdev, &ci);
+        if (copy_to_user(argp, &ci, sizeof(ci)))
+            return -EFAULT;
+        return 0;
+
+    default:
+        return -ENOIOCTLCMD;
+    }
+}
+
 /*Frame Buffer操作函数集*/
 static struct fb_ops xilinx_vdmafb_ops = {
     .owner = THIS_MODULE,
     .fb_setcolreg = vdmafb_setcolreg,
     .fb_check_var = vdmafb_check_var,
-    .fb_fillrect = cfb_fillrect,
-    .fb_copyarea = cfb_copyarea,
-    .fb_imageblit = cfb_imageblit,
+    .fb_open = vdmafb_open,
+    .fb_read = vdmafb_read,
+    .fb_write = vdmafb_write,
+    .fb_pan_display = vdmafb_pan_display,
+    .fb_blank = vdmafb_blank,
+    .fb_ioctl = vdmafb_ioctl,
+    .fb_mmap = vdmafb_mmap,
+    .fb_fillrect = vdmafb_fillrect,
+    .fb_copyarea = vdmafb_copyarea,
+    .fb_imageblit = vdmafb_imageblit,
 };
 
 
 
+#ifdef VDMAFB_SIM
+/*仿真后端没有设备树和LCD ID引脚,时序由平台数据给出*/
+static int vdmafb_init_fbinfo_dt(struct xilinx_vdmafb_dev *fbdev,struct videomode *vmode)
+{
+    struct device *dev = &fbdev->pdev->dev;
+
+    if (!dev_get_platdata(dev))
+        return -ENODEV;
+    *vmode = *(struct videomode *)dev_get_platdata(dev);
+    return 0;
+}
+#else
 static int vdmafb_init_fbinfo_dt(struct xilinx_vdmafb_dev *fbdev,struct videomode *vmode)
 {   
     struct device *dev = &fbdev->pdev->dev;
@@ -127,6 +1551,12 @@ static int vdmafb_init_fbinfo_dt(struct xilinx_vdmafb_dev *fbdev,struct videomod
     int i;
     int ret;
 
+    /*仿真后端等非设备树实例通过平台数据直接给出时序,无LCD ID引脚*/
+    if (dev_get_platdata(dev)) {
+        *vmode = *(struct videomode *)dev_get_platdata(dev);
+        return 0;
+    }
+
     // /* 获取 LCD ID GPIOs */
     // for (i = 0; i < 2; i++) {
     //     lcd_gpios[i] = devm_gpiod_get_index(dev, "lcdID", i, GPIOF_IN);
@@ -188,6 +1618,7 @@ static int vdmafb_init_fbinfo_dt(struct xilinx_vdmafb_dev *fbdev,struct videomod
     return 0;
 
 }
+#endif
 
 
 
@@ -196,9 +1627,9 @@ static int vdmafb_init_fbinfo(struct xilinx_vdmafb_dev *fbdev,struct videomode *
     struct device *dev = &fbdev->pdev->dev;
     struct fb_info *info = fbdev->fb_info;
     struct fb_videomode mode = {0};
-    dma_addr_t fb_phys;         //显存物理地址
-    void *fb_virt;              //显存虚拟地址
     unsigned fb_size;           //显存大小
+    u32 num_buffers = 1;        //显存缓冲区个数
+    u64 frame_pixels;
     int ret;
 
     /*解析设备树获取LCD时序参数*/
@@ -208,24 +1639,33 @@ static int vdmafb_init_fbinfo(struct xilinx_vdmafb_dev *fbdev,struct videomode *
         return ret;
     }
 
+    /*显存缓冲区个数,多缓冲时通过pan切换*/
+    device_property_read_u32(dev, "xlnx,num-buffers", &num_buffers);
+    num_buffers = clamp_t(u32, num_buffers, 1, VDMAFB_MAX_BUFFERS);
+    fbdev->num_buffers = num_buffers;
+
     /*申请LCD显存*/
-    fb_size = vmode->hactive * vmode->vactive * 3;
-    fb_virt = dma_alloc_wc(dev, PAGE_ALIGN(fb_size), &fb_phys, GFP_KERNEL);
-    if (!fb_virt) {
+    fbdev->buf_size = vmode->hactive * vmode->vactive * 3;
+    fb_size = fbdev->buf_size * num_buffers;
+    ret = vdmafb_alloc_mem(fbdev, ALIGN(fb_size, VDMAFB_MEM_ALIGN));
+    if (ret) {
         dev_err(dev, "Failed to allocate framebuffer\n");
-        return -ENOMEM;
+        return ret;
     }
 
     //打印显存物理地址和大小
-    dev_info(dev, "Frame Buffer physical address: 0x%lx - 0x%lx\n",
-         fb_phys, fb_phys + fb_size - 1);
-
-
-    memset(fb_virt, 0, fb_size);
+    dev_info(dev, "Frame Buffer physical address: %pa - 0x%llx, backend %d\n",
+         &fbdev->mem_phys, (u64)fbdev->mem_phys + fb_size - 1, fbdev->mem_type);
+    /*CMA按分配大小对齐,但受CONFIG_CMA_ALIGNMENT限制,未对齐时mmap只能用小页*/
+#ifdef VDMAFB_HUGE_MMAP
+    if (!IS_ALIGNED(fbdev->mem_phys, VDMAFB_MEM_ALIGN))
+        dev_warn(dev, "Frame Buffer not aligned to 0x%lx, mmap falls back to small pages\n",
+                 (unsigned long)VDMAFB_MEM_ALIGN);
+#endif
 
     /*初始化fb_info结构体*/
     info->fbops = &xilinx_vdmafb_ops;   //设置操作函数集
-    info->screen_base = fb_virt;        //显存虚拟地址
+    info->screen_base = fbdev->mem_virt;    //显存虚拟地址,无内核映射时为NULL
     info->screen_size = fb_size;        //显存大小
 
     //固定属性初始化（fix）
@@ -234,7 +1674,8 @@ static int vdmafb_init_fbinfo(struct xilinx_vdmafb_dev *fbdev,struct videomode *
     info->fix.visual = FB_VISUAL_TRUECOLOR;  //真彩色
     info->fix.accel = FB_ACCEL_NONE;         //不支持加速
     info->fix.line_length = vmode->hactive * 3;  //一行的字节数
-    info->fix.smem_start = fb_phys;             //显存物理地址
+    info->fix.ypanstep = vmode->vactive;         //按整个缓冲区平移
+    info->fix.smem_start = fbdev->mem_phys;     //显存物理地址
     info->fix.smem_len = fb_size;                //显存大小
 
     //可变属性初始化（var）
@@ -264,106 +1705,139 @@ static int vdmafb_init_fbinfo(struct xilinx_vdmafb_dev *fbdev,struct videomode *
     // 将 fb_videomode 转换为 fb_var_screeninfo 格式
     // info->var: Frame Buffer 可变参数结构，用于硬件寄存器配置（如分辨率、时序）
     // mode: 从上一步得到的 fb_videomode 数据，提供显示模式信息                 
+    info->var.yres_virtual = vmode->vactive * num_buffers;     //多缓冲时虚拟高度为缓冲区个数倍
+
+    /*由时序参数计算帧周期初值,之后由帧完成回调实测修正*/
+    frame_pixels = (u64)(vmode->hactive + vmode->hfront_porch + vmode->hsync_len + vmode->hback_porch) *
+                   (vmode->vactive + vmode->vfront_porch + vmode->vsync_len + vmode->vback_porch);
+    if (vmode->pixelclock)
+        fbdev->frame_period_ns = div_u64(frame_pixels * NSEC_PER_SEC, vmode->pixelclock);
+    else
+        fbdev->frame_period_ns = NSEC_PER_SEC / 60;
 
     return 0;
 
 }
 
+/*
+ * 写入VDMA通道配置。仿真后端(VDMAFB_SIM)的虚拟dmaengine不是Xilinx VDMA,
+ * 没有对应的私有配置接口
+ */
+static int vdmafb_config_vdma(struct xilinx_vdmafb_dev *fbdev)
+{
+#ifdef VDMAFB_SIM
+    return 0;
+#else
+    return xilinx_vdma_channel_set_config(fbdev->vdma, &fbdev->vdma_config);
+#endif
+}
+
+/*
+ * 从当前前台缓冲区(或最新pan的缓冲区)开始逐帧提交
+ * 迟锁存模式下第一帧完成后由帧完成回调接着启动定时器
+ */
+static int vdmafb_start_vdma(struct xilinx_vdmafb_dev *fbdev)
+{
+    unsigned long flags;
+    int ret;
+
+    /*停止时已终止全部描述符,重新开始计数*/
+    spin_lock_irqsave(&fbdev->lock, flags);
+    fbdev->queued = 0;
+    fbdev->queued_head = 0;
+    ret = vdmafb_submit_frame(fbdev, vdmafb_take_pending(fbdev));
+    fbdev->running = !ret;
+    spin_unlock_irqrestore(&fbdev->lock, flags);
+    return ret;
+}
+
 static int vdmafb_init_vdma(struct xilinx_vdmafb_dev *fbdev)
 {
     struct device *dev = &fbdev->pdev->dev;
     struct fb_info *info = fbdev->fb_info;
     struct dma_interleaved_template *dma_template;
-    struct dma_async_tx_descriptor *tx_desc;
-    struct xilinx_vdma_config vdma_config={0};
+    struct xilinx_vdma_config *vdma_config = &fbdev->vdma_config;
     int ret;
 
-size_t num_sgl = 1; // 假设需要 1 个 sgl
-dma_template = kzalloc(sizeof(*dma_template) + sizeof(struct data_chunk) * num_sgl, GFP_KERNEL);
-if (!dma_template) {
-    dev_err(dev, "Failed to allocate memory for dma_template\n");
-    return -ENOMEM;
-}
+    /*描述符模板保存在fbdev中,每帧提交时复用*/
+    dma_template = devm_kzalloc(dev, sizeof(*dma_template) + sizeof(struct data_chunk), GFP_KERNEL);
+    if (!dma_template) {
+        dev_err(dev, "Failed to allocate memory for dma_template\n");
+        return -ENOMEM;
+    }
+    fbdev->dma_template = dma_template;
 
     dev_info(dev, "Step 1: Requesting VDMA channel\n");
     /*申请vdma通道*/
-    fbdev->vdma = of_dma_request_slave_channel(dev->of_node, "lcd_vdma");
+    fbdev->vdma = dma_request_chan(dev, "lcd_vdma");
     if (IS_ERR(fbdev->vdma)) {
         dev_err(dev, "Failed to request vdma channel\n");
         return PTR_ERR(fbdev->vdma);
     }
-    dev_info(dev, "Step 2: VDMA channel requested successfully\n");
-    dev_info(dev, "VDMA channel address: %p\n", fbdev->vdma);
     if(!fbdev->vdma)
     {
         dev_err(dev, "Failed to get VDMA channel\n");
         return -ENODEV;
     }
-    //dma_template->sgl[0].size
-    dev_info(dev, "dma_template->sgl[0].size: %d\n", dma_template->sgl[0].size);
-
-
-/* 终止VDMA通道数据传输 */
-dev_info(dev, "Step 3: Terminating all VDMA transactions\n");
-dmaengine_terminate_all(fbdev->vdma);
-
-/* 初始化VDMA通道 */
-dev_info(dev, "Step 4: Initializing VDMA template\n");
-dma_template->dir = DMA_MEM_TO_DEV;  // 从内存到外设
-dma_template->numf = info->var.yres; // 行数
-dma_template->sgl[0].size = info->fix.line_length;  // 一行的字节数
-dma_template->frame_size = 1;        // 帧大小
-dma_template->sgl[0].icg = 0;        // 间隔
-dma_template->src_start = info->fix.smem_start;  // 物理地址
-dma_template->src_sgl = 1;           // 单个源地址分散模式
-dma_template->src_inc = 1;           // 源地址递增
-dma_template->dst_inc = 0;           // 目的地址固定
-dma_template->dst_sgl = 0;           // 单个目的地址
-
-/* 检查模板初始化后的值 */
-dev_info(dev, "dma_template->dir: %d\n", dma_template->dir);
-dev_info(dev, "dma_template->numf: %d\n", dma_template->numf);
-dev_info(dev, "dma_template->sgl[0].size: %d\n", dma_template->sgl[0].size);
-dev_info(dev, "dma_template->src_start: 0x%llx\n", dma_template->src_start);
-
-/* 生成描述符 */
-dev_info(dev, "Step 5: Preparing DMA descriptor\n");
-tx_desc = dmaengine_prep_interleaved_dma(fbdev->vdma, dma_template, DMA_CTRL_ACK | DMA_PREP_INTERRUPT);
-if (!tx_desc) {
-    dev_err(dev, "Failed to prepare slave transfer\n");
-    dma_release_channel(fbdev->vdma);
-    return -ENOMEM;
-}
-dev_info(dev, "Step 6: DMA descriptor prepared successfully\n");
-
-/* 配置VDMA通道 */
-dev_info(dev, "Step 7: Configuring VDMA channel\n");
-vdma_config.park = 1;
-ret = xilinx_vdma_channel_set_config(fbdev->vdma, &vdma_config);
-if(ret !=0)
-{
-    dev_info(dev,"xilinx_vdma_channel_set_config error!");
-    return -ENOMEM;
-}
+    dev_info(dev, "Step 2: VDMA channel requested successfully\n");
 
-/* 启动VDMA通道 */
-dev_info(dev, "Step 8: Submitting DMA descriptor\n");
-ret = dmaengine_submit(tx_desc);
-if(ret < 0)
-{
-    dev_info(dev,"dmaengine_submit error!");
-    return -ENOMEM;
-}
+    /* 终止VDMA通道数据传输 */
+    dev_info(dev, "Step 3: Terminating all VDMA transactions\n");
+    dmaengine_terminate_all(fbdev->vdma);
+
+    /* 初始化VDMA通道 */
+    dev_info(dev, "Step 4: Initializing VDMA template\n");
+    dma_template->dir = DMA_MEM_TO_DEV;  // 从内存到外设
+    dma_template->numf = info->var.yres; // 行数
+    dma_template->sgl[0].size = info->fix.line_length;  // 一行的字节数
+    dma_template->frame_size = 1;        // 帧大小
+    dma_template->sgl[0].icg = 0;        // 间隔
+    dma_template->src_start = info->fix.smem_start;  // 物理地址
+    dma_template->src_sgl = 1;           // 单个源地址分散模式
+    dma_template->src_inc = 1;           // 源地址递增
+    dma_template->dst_inc = 0;           // 目的地址固定
+    dma_template->dst_sgl = 0;           // 单个目的地址
+
+    /* 配置VDMA通道 */
+    dev_info(dev, "Step 5: Configuring VDMA channel\n");
+    memset(vdma_config, 0, sizeof(*vdma_config));
+    vdma_config->park = 1;
+    vdma_config->coalesc = 1;            // 每帧产生一次帧完成中断,作为vblank
+    ret = vdmafb_config_vdma(fbdev);
+    if(ret !=0)
+    {
+        dev_err(dev,"xilinx_vdma_channel_set_config error!\n");
+        dma_release_channel(fbdev->vdma);
+        return ret;
+    }
 
-dev_info(dev, "Step 9: Starting DMA transaction\n");
- dma_async_issue_pending(fbdev->vdma);
+    /* 启动VDMA通道,之后每帧由帧完成回调或迟锁存定时器继续提交 */
+    dev_info(dev, "Step 6: Submitting first frame\n");
+    fbdev->front_addr = info->fix.smem_start;
+    fbdev->scanned_addr = info->fix.smem_start;
+    ret = vdmafb_start_vdma(fbdev);
+    if (ret) {
+        dev_err(dev, "Failed to submit DMA descriptor\n");
+        dma_release_channel(fbdev->vdma);
+        return ret;
+    }
 
-dev_info(dev, "Step 10: VDMA initialized successfully\n");
-kfree(dma_template);
+    dev_info(dev, "Step 7: VDMA initialized successfully\n");
+    return 0;
+}
 
+/*停止逐帧提交并终止VDMA传输*/
+static void vdmafb_stop_vdma(struct xilinx_vdmafb_dev *fbdev)
+{
+    unsigned long flags;
 
-return 0;
+    spin_lock_irqsave(&fbdev->lock, flags);
+    fbdev->running = false;
+    spin_unlock_irqrestore(&fbdev->lock, flags);
 
+    hrtimer_cancel(&fbdev->latch_timer);
+    dmaengine_terminate_all(fbdev->vdma);
+    wake_up_interruptible_all(&fbdev->vblank_wait);
 }
 
 static int vdmafb_init_vtc(struct xilinx_vdmafb_dev *fbdev, struct videomode *vmode)
@@ -383,7 +1857,7 @@ static int vdmafb_init_vtc(struct xilinx_vdmafb_dev *fbdev, struct videomode *vm
 
     /* 获取 VTC 设备 */
     fbdev->vtc = xvtc_of_get(dev->of_node);
-    dev_info(dev, "VTC node: %s\n", dev->of_node->name);
+    dev_info(dev, "VTC node: %pOF\n", dev->of_node);
     dev_info(dev, "VTC device address: %p\n", fbdev->vtc);
 
     //of_node_put(node);  //释放设备节点引用
@@ -406,6 +1880,7 @@ static int vdmafb_init_vtc(struct xilinx_vdmafb_dev *fbdev, struct videomode *vm
     config.vsize = vmode->vactive + vmode->vfront_porch + vmode->vsync_len + vmode->vback_porch;
     
     config.fps = 60;
+    fbdev->vtc_config = config;         //保存,唤醒时直接恢复
         /* 启动 VTC 生成器 */
     ret = xvtc_generator_start(fbdev->vtc, &config);
     if (ret) {
@@ -419,6 +1894,39 @@ static int vdmafb_init_vtc(struct xilinx_vdmafb_dev *fbdev, struct videomode *vm
 
 }
 
+/*关闭显示输出:先停止VDMA提交,再停止VTC时序*/
+static void vdmafb_display_off(struct xilinx_vdmafb_dev *fbdev)
+{
+    vdmafb_stop_vdma(fbdev);
+    xvtc_generator_stop(fbdev->vtc);
+}
+
+/*恢复显示输出,从当前前台缓冲区(或关闭期间pan的缓冲区)开始扫描*/
+static int vdmafb_display_on(struct xilinx_vdmafb_dev *fbdev)
+{
+    struct device *dev = &fbdev->pdev->dev;
+    int ret;
+
+    ret = xvtc_generator_start(fbdev->vtc, &fbdev->vtc_config);
+    if (ret) {
+        dev_err(dev, "Failed to restart VTC generator\n");
+        return ret;
+    }
+
+    ret = vdmafb_config_vdma(fbdev);
+    if (ret) {
+        dev_err(dev, "Failed to restore VDMA config\n");
+        return ret;
+    }
+
+    ret = vdmafb_start_vdma(fbdev);
+    if (ret) {
+        dev_err(dev, "Failed to restart VDMA\n");
+        return ret;
+    }
+    return 0;
+}
+
 
 
 static int vdmafb_probe(struct platform_device *pdev)
@@ -443,9 +1951,29 @@ static int vdmafb_probe(struct platform_device *pdev)
     fbdev->fb_info = info;
     fbdev->pdev = pdev;
 
+    spin_lock_init(&fbdev->lock);
+    mutex_init(&fbdev->kmap_lock);
+    mutex_init(&fbdev->cap.mutex);
+    spin_lock_init(&fbdev->cap.lock);
+    init_waitqueue_head(&fbdev->cap.wait);
+    spin_lock_init(&fbdev->crc.lock);
+    INIT_WORK(&fbdev->crc.work, vdmafb_crc_work);
+    init_waitqueue_head(&fbdev->vblank_wait);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+    hrtimer_setup(&fbdev->latch_timer, vdmafb_latch_timer_fn, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+#else
+    hrtimer_init(&fbdev->latch_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+    fbdev->latch_timer.function = vdmafb_latch_timer_fn;
+#endif
+    fbdev->present_mode = VDMAFB_PRESENT_VBLANK;
+    fbdev->latch_margin_us = VDMAFB_DEFAULT_MARGIN_US;
+
     dev_info(&pdev->dev, "Device tree node: %pOF\n", pdev->dev.of_node);
     /*获取LCD所需时钟*/
-    fbdev->pclk =  devm_clk_get(&pdev->dev, "lcd_pclk");
+    if (pdev->dev.of_node)
+        fbdev->pclk =  devm_clk_get(&pdev->dev, "lcd_pclk");
+    else
+        fbdev->pclk = NULL;     /*仿真后端没有像素时钟,clk接口对NULL为空操作*/
     if(IS_ERR(fbdev->pclk))
     {
         dev_err(&pdev->dev, "failed to get lcd_pclk\n");
@@ -514,7 +2042,7 @@ static int vdmafb_probe(struct platform_device *pdev)
     return 0;
 
 out6:
-    dmaengine_terminate_all(fbdev->vdma);   //终止VDMA通道数据传输
+    vdmafb_stop_vdma(fbdev);                //终止VDMA通道数据传输
     dma_release_channel(fbdev->vdma);       //释放VDMA通道
 out5:
     xvtc_generator_stop(fbdev->vtc);        //停止VTC生成器
@@ -524,40 +2052,109 @@ out5:
 out3:
     fb_dealloc_cmap(&info->cmap);           //释放调色板
 out2:
-    dma_free_wc(&pdev->dev, PAGE_ALIGN(info->screen_size), info->screen_base, info->fix.smem_start);  //释放显存
+    vdmafb_free_mem(fbdev);                 //释放显存
 out1:
     framebuffer_release(info);              //释放framebuffer设备
     return ret;
 
 }
 
+/*6.11起platform_driver的remove不再返回值*/
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 11, 0)
+static void vdmafb_remove(struct platform_device *pdev)
+#else
 static int vdmafb_remove(struct platform_device *pdev)
+#endif
 {
     struct xilinx_vdmafb_dev *fbdev = platform_get_drvdata(pdev);
     struct fb_info *info = fbdev->fb_info;
 
 
     unregister_framebuffer(info);   //注销framebuffer设备
-    dmaengine_terminate_all(fbdev->vdma);  //终止VDMA通道数据传输
+    vdmafb_capture_stop(fbdev);            //停止抓屏
+    vdmafb_crc_enable(fbdev, false);       //停止帧校验
+    vdmafb_stop_vdma(fbdev);               //终止VDMA通道数据传输
     dma_release_channel(fbdev->vdma);      //释放VDMA通道
     xvtc_generator_stop(fbdev->vtc);       //停止VTC生成器
     //clk_disable_unprepare(fbdev->pclk);    //关闭像素时钟
     fb_dealloc_cmap(&info->cmap);          //释放调色板
-    dma_free_wc(&pdev->dev, PAGE_ALIGN(info->screen_size), info->screen_base, info->fix.smem_start);  //释放显存
+    vdmafb_free_mem(fbdev);                 //释放显存
     framebuffer_release(info);             //释放framebuffer设备
 
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 11, 0)
     return 0;
+#endif
 }
 
 static void vdmafb_shutdown(struct platform_device *pdev)
 {
 
     struct xilinx_vdmafb_dev *fbdev = platform_get_drvdata(pdev);
+    vdmafb_stop_vdma(fbdev);               //停止逐帧提交
     xvtc_generator_stop(fbdev->vtc);       //停止VTC生成器
     //clk_disable_unprepare(fbdev->pclk);    //关闭像素时钟
 }
 
 
+/*
+ * 休眠时显存保留在DDR自刷新中,只停止VDMA和VTC;
+ * 唤醒时用保存的VTC配置和描述符模板恢复,一帧之内重新出图,不需要重新探测和重绘
+ */
+static int __maybe_unused vdmafb_suspend(struct device *dev)
+{
+    struct xilinx_vdmafb_dev *fbdev = dev_get_drvdata(dev);
+    struct vdmafb_capture *cap = &fbdev->cap;
+    unsigned long flags;
+
+    console_lock();
+    fb_set_suspend(fbdev->fb_info, 1);  //停止fbcon绘制
+    console_unlock();
+
+    /*暂停抓屏和帧校验,缓冲区保留*/
+    spin_lock_irqsave(&cap->lock, flags);
+    cap->suspended_active = cap->active;
+    cap->active = false;
+    spin_unlock_irqrestore(&cap->lock, flags);
+    wait_event_timeout(cap->wait, !READ_ONCE(cap->busy), msecs_to_jiffies(100));
+    cancel_work_sync(&fbdev->crc.work);
+
+    /*已经blank时显示输出已关闭*/
+    if (!fbdev->blanked)
+        vdmafb_display_off(fbdev);
+    return 0;
+}
+
+static int __maybe_unused vdmafb_resume(struct device *dev)
+{
+    struct xilinx_vdmafb_dev *fbdev = dev_get_drvdata(dev);
+    struct vdmafb_capture *cap = &fbdev->cap;
+    unsigned long flags;
+    int ret;
+
+    /*休眠前已经blank的保持关闭,等unblank时再恢复*/
+    if (!fbdev->blanked) {
+        ret = vdmafb_display_on(fbdev);
+        if (ret)
+            return ret;
+    }
+
+    /*恢复休眠前的抓屏,从唤醒后的第一帧开始*/
+    spin_lock_irqsave(&cap->lock, flags);
+    if (cap->suspended_active && cap->count) {
+        cap->countdown = 1;
+        cap->active = true;
+    }
+    cap->suspended_active = false;
+    spin_unlock_irqrestore(&cap->lock, flags);
+
+    console_lock();
+    fb_set_suspend(fbdev->fb_info, 0);
+    console_unlock();
+    return 0;
+}
+
+static SIMPLE_DEV_PM_OPS(vdmafb_pm_ops, vdmafb_suspend, vdmafb_resume);
+
 static const struct of_device_id vdmafb_of_match_table[] = {
     { .compatible = "xilinx,vdmafb" },
     { },
@@ -569,6 +2166,7 @@ static struct platform_driver xilinx_vdmafb_driver = {
     .driver = {
         .name = "xilinx-vdmafb",
         .of_match_table = vdmafb_of_match_table,
+        .pm = &vdmafb_pm_ops,
     },
     .probe = vdmafb_probe,
     .remove = vdmafb_remove,
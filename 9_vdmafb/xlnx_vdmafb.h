@@ -0,0 +1,79 @@
+/*
+ * xlnx_vdmafb 私有ioctl定义
+ * 驱动与用户空间程序(test_app等)共用此头文件
+ */
+#ifndef __XLNX_VDMAFB_H
+#define __XLNX_VDMAFB_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/*显示提交模式*/
+#define VDMAFB_PRESENT_VBLANK       0   /*在帧完成中断中提交,下一帧之后生效*/
+#define VDMAFB_PRESENT_LATE_LATCH   1   /*在预测的vblank之前由hrtimer提交,紧接着的一帧生效*/
+
+struct vdmafb_present_mode {
+    __u32 mode;                 /*VDMAFB_PRESENT_xxx*/
+    __u32 latch_margin_us;      /*迟锁存提前于预测vblank的时间,0表示使用默认值*/
+};
+
+/*vblank信息,时间均为CLOCK_MONOTONIC纳秒*/
+struct vdmafb_vblank_info {
+    __u64 sequence;             /*已完成的帧计数*/
+    __u64 last_vblank_ns;       /*最近一次帧完成时间*/
+    __u64 period_ns;            /*预测的帧周期*/
+    __u64 next_vblank_ns;       /*预测的下一次帧完成时间*/
+    __u64 deadline_ns;          /*提交期限,在此之前pan的缓冲区可赶上下一帧*/
+    __u32 mode;                 /*当前提交模式*/
+    __u32 latch_margin_us;      /*当前迟锁存提前量*/
+};
+
+/*抓屏模式*/
+#define VDMAFB_CAPTURE_ONESHOT      0   /*在下一次vblank抓取一帧*/
+#define VDMAFB_CAPTURE_CONTINUOUS   1   /*每interval帧抓取一帧,直到停止*/
+
+#define VDMAFB_CAPTURE_MAX_BUFS     8
+
+struct vdmafb_capture_start {
+    __u32 mode;                 /*VDMAFB_CAPTURE_xxx*/
+    __u32 interval;             /*连续模式下每interval帧抓取一次,0等同于1*/
+    __u32 count;                /*环形缓冲区个数,1~VDMAFB_CAPTURE_MAX_BUFS*/
+    __u32 buf_size;             /*输出:每个缓冲区的mmap大小*/
+    __u64 mmap_offset;          /*输出:第i个缓冲区的mmap偏移为mmap_offset + i * buf_size*/
+};
+
+struct vdmafb_capture_buf {
+    __u32 index;                /*缓冲区序号*/
+    __u32 bytesused;            /*有效数据长度,即一帧的大小*/
+    __u64 sequence;             /*抓取序号,不连续表示有帧因未及时取走被覆盖*/
+    __u64 vblank;               /*抓取时的vblank计数*/
+    __u64 timestamp_ns;         /*抓取时的vblank时间,CLOCK_MONOTONIC*/
+};
+
+/*损坏区域,按虚拟分辨率中的行计*/
+struct vdmafb_damage {
+    __u32 y;                    /*起始行*/
+    __u32 height;               /*行数*/
+};
+
+/*帧完整性签名*/
+struct vdmafb_crc_info {
+    __u64 vblank;               /*计算签名时的vblank计数*/
+    __u64 timestamp_ns;         /*该vblank的时间*/
+    __u32 signature;            /*前台缓冲区各行CRC再做CRC32得到的帧签名*/
+    __u32 lines_hashed;         /*本次重新计算CRC的行数*/
+    __u32 yoffset;              /*签名对应的前台缓冲区起始行*/
+    __u32 reserved;
+};
+
+#define VDMAFB_IOCTL_SET_PRESENT_MODE   _IOW('F', 0xA0, struct vdmafb_present_mode)
+#define VDMAFB_IOCTL_GET_VBLANK         _IOR('F', 0xA1, struct vdmafb_vblank_info)
+#define VDMAFB_IOCTL_CAPTURE_START      _IOWR('F', 0xA2, struct vdmafb_capture_start)
+#define VDMAFB_IOCTL_CAPTURE_STOP       _IO('F', 0xA3)
+#define VDMAFB_IOCTL_CAPTURE_DQBUF      _IOR('F', 0xA4, struct vdmafb_capture_buf)
+#define VDMAFB_IOCTL_CAPTURE_QBUF       _IOW('F', 0xA5, __u32)
+#define VDMAFB_IOCTL_CRC_ENABLE         _IOW('F', 0xA6, __u32)
+#define VDMAFB_IOCTL_DAMAGE             _IOW('F', 0xA7, struct vdmafb_damage)
+#define VDMAFB_IOCTL_GET_CRC            _IOR('F', 0xA8, struct vdmafb_crc_info)
+
+#endif